@@ -0,0 +1,112 @@
+#ifndef __LIBTASMOTA_COMPILEDPATH_HPP__
+#define __LIBTASMOTA_COMPILEDPATH_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <JsonCpp.hpp>
+#include <PathInterner.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a pre-parsed key path into a json tree.
+     * The key path is a string containing path segments, separated by ':' characters. It is parsed once on
+     * construction and can then be evaluated against any number of json trees. Each segment is one of:
+     *  - a key name, e.g. "ENERGY"; on json arrays a purely numeric segment is used as an array index
+     *  - a wildcard "*", matching all entries of a json object or all elements of a json array
+     *  - an array slice "first..last", matching array elements first up to but excluding last, e.g. "0..2" or "1.."
+     *  - a set of alternative key names "{A,B,C}", e.g. "StatusSNS:ENERGY:{Power,Voltage,Current}"
+     * Key names of intermediate segments are compared case-insensitively; the key names of the last segment
+     * additionally ignore trailing digits, i.e. "Power" matches "POWER1". All matches are collected in a
+     * single traversal of the json tree.
+     */
+    class CompiledPath {
+
+    public:
+
+        /** Type of a compiled path segment. */
+        enum SegmentType {
+            SEGMENT_NAME,           ///< a single key name, or an array index if the name is numeric
+            SEGMENT_WILDCARD,       ///< "*"
+            SEGMENT_SLICE,          ///< "first..last"
+            SEGMENT_ALTERNATIVES    ///< "{A,B,C}"
+        };
+
+        /** Compiled path segment. */
+        struct Segment {
+            SegmentType              type;      ///< segment type
+            std::vector<std::string> names;     ///< key name, or the list of alternative key names
+            unsigned int             first;     ///< array index of a numeric key name, or the first index of a slice
+            unsigned int             last;      ///< index after the last element of a slice
+            bool                     numeric;   ///< true, if first holds a valid array index
+        };
+
+        /** Path match, holding the concrete key path and the matching json value. */
+        struct Match {
+            PathInterner::PathId path_id;       ///< id of the concrete key path, if it has been interned, e.g. by compiling it; INVALID_ID otherwise
+            std::string          path;          ///< concrete key path of the match, e.g. "StatusSNS:ENERGY:Power"; empty if path_id is valid
+            JsonCpp::JsonValue   value;         ///< matching json value; it points into the evaluated json tree
+            Match(const PathInterner::PathId _path_id, const std::string& _path, const JsonCpp::JsonValue& _value) : path_id(_path_id), path(_path), value(_value) {}
+            const std::string& getPath(void) const { return (path_id != PathInterner::INVALID_ID ? PathInterner::instance().getPath(path_id) : path); }  ///< Get the concrete key path of the match.
+        };
+        typedef std::vector<Match> MatchVector;
+
+        CompiledPath(void);
+        explicit CompiledPath(const std::string& path);
+
+        const std::string&          getPath    (void) const { return path; }            ///< Get the key path this instance was compiled from.
+        PathInterner::PathId        getPathId  (void) const { return path_id; }         ///< Get the interned key path this instance was compiled from.
+        const std::vector<Segment>& getSegments(void) const { return segments; }        ///< Get the compiled path segments.
+        bool                        isValid    (void) const { return !segments.empty(); } ///< True, if the path contains at least one segment.
+        bool                        isSingle   (void) const { return single; }          ///< True, if the path can match at most one json value.
+
+        size_t             evaluate     (const json_value* const json, MatchVector& matches) const;
+        JsonCpp::JsonValue evaluateFirst(const json_value* const json) const;
+
+    protected:
+
+        std::string          path;
+        PathInterner::PathId path_id;
+        std::vector<Segment> segments;
+        bool                 single;
+
+        void compile(void);
+        static bool parseIndex(const std::string& text, unsigned int& index);
+        void traverse(const JsonCpp::JsonValue& node, const size_t segment_index, std::string& match_path, MatchVector* matches, JsonCpp::JsonValue* first) const;
+    };
+
+}   // namespace libtasmota
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef __LIBTASMOTA_ENERGYAGGREGATOR_HPP__
+#define __LIBTASMOTA_ENERGYAGGREGATOR_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <functional>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <JsonBatch.hpp>
+#include <PathInterner.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing running energy aggregates for groups of devices, e.g. all plugs of a site.
+     * Each power sample of a device updates the aggregates of all groups the device belongs to in O(1): the sum of the latest
+     * power of all devices, a time-weighted exponential moving average of that sum, the energy integral of the power, and the
+     * sum of the latest energy counter ("Total") of all devices. No sample history is kept or recomputed.
+     * If a max sample age is configured, devices without a recent power sample, e.g. offline devices, drop out of the power sum
+     * and are not integrated until a fresh sample arrives; see expireDevices(). Power samples are queued by time, so that expiry only
+     * visits outdated samples instead of all devices.
+     * Updates are serialized by a mutex. After each update the aggregates of a group are published to a per-group slot guarded
+     * by a sequence lock, so that dashboards can read consistent snapshots without taking a lock and without blocking updates.
+     * The number of groups is fixed on construction, so that the slots never move.
+     */
+    class EnergyAggregator {
+
+    public:
+
+        typedef uint32_t GroupId;
+        static const GroupId INVALID_GROUP = 0xffffffff;    ///< id returned if a group cannot be added
+
+        /** Energy sample of a device. */
+        struct Sample {
+            uint32_t device_id;     ///< device id, e.g. as used in JsonBatch or TasmotaFleet
+            int64_t  time;          ///< sample time in milliseconds, e.g. since the epoch
+            double   power;         ///< active power in W, e.g. "StatusSNS:ENERGY:Power"
+            double   total;         ///< energy counter in kWh, e.g. "StatusSNS:ENERGY:Total"
+        };
+
+        /** Consistent snapshot of the aggregates of a group. */
+        struct GroupSnapshot {
+            int64_t  time;          ///< time of the latest sample of any device in the group
+            double   power;         ///< sum of the latest power of all devices in W
+            double   average_power; ///< exponential moving average of the power sum in W
+            double   energy;        ///< integral of the power sum in kWh since the devices have been added
+            double   total;         ///< sum of the latest energy counters of all devices in kWh
+            uint32_t devices;       ///< number of devices whose latest power is in the power sum
+            uint64_t samples;       ///< number of power samples aggregated
+            GroupSnapshot(void) : time(0), power(0.0), average_power(0.0), energy(0.0), total(0.0), devices(0), samples(0) {}
+        };
+
+        EnergyAggregator(const size_t max_groups, const int64_t average_period_ms = 60000, const int64_t max_sample_age_ms = 0);
+
+        GroupId addGroup(const std::string& name);
+        bool    addDevice(const uint32_t device_id, const GroupId group_id);
+        void    removeDevice(const uint32_t device_id);
+
+        void   update(const Sample& sample);
+        bool   updatePower(const uint32_t device_id, const int64_t time, const double power);
+        bool   updateTotal(const uint32_t device_id, const int64_t time, const double total);
+        size_t update(const JsonBatch& batch, const int64_t time);
+        size_t expireDevices(const int64_t time);
+
+        bool   getSnapshot(const GroupId group_id, GroupSnapshot& snapshot) const;
+        size_t getNumGroups(void) const { return num_groups.load(std::memory_order_acquire); }     ///< number of groups added so far
+        const std::string& getGroupName(const GroupId group_id) const;
+        int64_t getMaxSampleAge(void) const { return max_sample_age; }     ///< max age of a power sample in milliseconds; 0 if samples do not expire
+
+    protected:
+
+        /** Aggregates of a group; only accessed by writers holding the mutex. */
+        struct GroupState {
+            int64_t  time;
+            int64_t  average_time;
+            double   power;
+            double   average_power;
+            double   energy;
+            double   total;
+            uint32_t devices;
+            uint64_t samples;
+        };
+
+        /** Published aggregates of a group, guarded by a sequence lock; the sequence number is odd while a write is in progress. */
+        struct GroupSlot {
+            std::string           name;
+            std::atomic<uint32_t> sequence;
+            std::atomic<int64_t>  time;
+            std::atomic<double>   power;
+            std::atomic<double>   average_power;
+            std::atomic<double>   energy;
+            std::atomic<double>   total;
+            std::atomic<uint32_t> devices;
+            std::atomic<uint64_t> samples;
+        };
+
+        /** Power sample time and device id, queued for expiry; entries of samples that have been superseded are skipped. */
+        typedef std::pair<int64_t, uint32_t> Expiry;
+
+        /** Latest samples of a device. */
+        struct DeviceState {
+            std::vector<GroupId> groups;
+            int64_t power_time;
+            double  power;
+            bool    has_power;
+            bool    power_expired;  // the power is not in the sums of the groups, see expireDevices()
+            int64_t total_time;
+            double  total;
+            bool    has_total;
+        };
+
+        const size_t  max_groups;
+        const int64_t average_period;
+        const int64_t max_sample_age;
+
+        std::unique_ptr<GroupSlot[]>  slots;                // published aggregates, indexed by group id
+        std::vector<GroupState>       groups;               // aggregates, indexed by group id
+        std::atomic<size_t>           num_groups;           // number of published groups
+        std::unordered_map<uint32_t, DeviceState> devices;  // device id => latest samples
+        std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry> > expiry_queue;  // power samples, oldest first
+        std::mutex                    mutex;                // serializes writers
+        const PathInterner::PathId    power_path;           // "StatusSNS:ENERGY:Power"
+        const PathInterner::PathId    total_path;           // "StatusSNS:ENERGY:Total"
+
+        bool updatePowerLocked(const uint32_t device_id, const int64_t time, const double power);
+        bool updateTotalLocked(const uint32_t device_id, const int64_t time, const double total);
+        size_t expireDevicesLocked(const int64_t time);
+        void compactExpiryQueue(void);
+        void advanceAverage(GroupState& group, const int64_t time) const;
+        void publish(const GroupId group_id);
+
+    private:
+        EnergyAggregator(const EnergyAggregator&);
+        EnergyAggregator& operator=(const EnergyAggregator&);
+    };
+
+}   // namespace libtasmota
+
+#endif
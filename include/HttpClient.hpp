@@ -2,6 +2,10 @@
 #define __RALFOGIT_HTTPCLIENT_HPP__
 
 #include <string>
+#include <chrono>
+#include <memory>
+
+struct addrinfo;    // declared in <netdb.h> or <Ws2tcpip.h>
 
 #ifdef LIB_NAMESPACE
 namespace LIB_NAMESPACE {
@@ -9,28 +13,85 @@ namespace LIB_NAMESPACE {
 namespace libralfogit {
 #endif
 
+    /**
+     *  Class implementing a pre-parsed http endpoint. The url is parsed and validated once; host, port, path prefix
+     *  and the constant request header lines, including the authorization header, are kept for any number of requests.
+     *  The host name is resolved by the first request only; only this lookup is not bounded by the request timeout.
+     */
+    class HttpEndpoint {
+    public:
+        HttpEndpoint(void);
+        explicit HttpEndpoint(const std::string& url);
+
+        bool               isValid      (void) const { return valid; }          ///< True, if the url could be parsed and uses the http protocol.
+        const std::string& getHost      (void) const { return host; }           ///< Host name or address.
+        int                getPort      (void) const { return port; }           ///< Port number.
+        const std::string& getPathPrefix(void) const { return path_prefix; }    ///< Percent-encoded prefix of each request target, e.g. "/cm?cmnd=".
+        const std::string& getHeaders   (void) const { return headers; }        ///< Constant request header lines, each terminated by "\r\n".
+
+        void setPathPrefix(const std::string& prefix) { path_prefix = prefix; } ///< Set the percent-encoded prefix of each request target.
+
+    protected:
+        friend class HttpClient;
+
+        std::string host;
+        int         port;
+        std::string path_prefix;
+        std::string headers;
+        bool        valid;
+        mutable std::shared_ptr<const struct addrinfo> addresses;   // resolved host addresses, cached by the first successful connect
+    };
+
     /**
      *  Class implementing a very basic http client.
      */
     class HttpClient {
     public:
 
+        /**
+         *  Interface for receiving http content piece by piece, while it is arriving from the server.
+         */
+        class ContentConsumer {
+        public:
+            virtual ~ContentConsumer(void) {}
+            virtual bool begin(const int http_return_code) { (void)http_return_code; return true; }   ///< Called once after the http header, before any content; return false to stop receiving.
+            virtual bool consume(const char* data, size_t length) = 0;   ///< Consume the next piece of content; return false to stop receiving.
+        };
+
         HttpClient(void);
         ~HttpClient(void);
 
+        void setTimeout(const int timeout_ms) { timeout = timeout_ms; }    ///< Set the max time in milliseconds for connecting, sending and receiving a request; default 5000.
+        int  getTimeout(void) const { return timeout; }                     ///< Get the max time in milliseconds for a request.
+
         int sendHttpGetRequest(const std::string& url, std::string& response, std::string& content);
+        int sendHttpGetRequest(const std::string& url, std::string& response, ContentConsumer& consumer);
         int sendHttpPutRequest(const std::string& url, const std::string& request_data, std::string& response, std::string& content);
         int sendHttpPostRequest(const std::string& url, const std::string& request_data, std::string& response, std::string& content);
 
+        int sendHttpGetRequest(const HttpEndpoint& endpoint, const std::string& target, std::string& response, std::string& content);
+        int sendHttpGetRequest(const HttpEndpoint& endpoint, const std::string& target, std::string& response, ContentConsumer& consumer);
+        int sendHttpPutRequest(const HttpEndpoint& endpoint, const std::string& target, const std::string& request_data, std::string& response, std::string& content);
+
     protected:
+        friend class HttpEndpoint;
 
         char* recv_buffer;
         size_t recv_buffer_size;
+        int timeout;
+        std::chrono::steady_clock::time_point deadline;     // end of the current request, i.e. its start plus timeout
 
-        int sendHttpRequest(const std::string& url, const std::string& method, const std::string& request_data, std::string& response, std::string& content);
-        int connect_to_server(const std::string& host, const int port);
+        int sendHttpRequest(const HttpEndpoint& endpoint, const std::string& target, const char* method, const std::string& request_data, std::string& response, std::string& content);
+        int sendHttpRequest(const HttpEndpoint& endpoint, const std::string& target, const char* method, const std::string& request_data, std::string& response, ContentConsumer& consumer);
+        int open_request(const HttpEndpoint& endpoint, const std::string& target, const char* method, const std::string& request_data, std::string& request);
+        int connect_to_server(const HttpEndpoint& endpoint);
+        bool send_request(const int socket_fd, const std::string& request);
         int communicate_with_server(const int socket_fd, const std::string& request, std::string& response, std::string& content);
+        int communicate_with_server(const int socket_fd, const std::string& request, std::string& response, ContentConsumer& consumer);
         size_t recv_http_response(int socket_fd);
+        int    recv_http_response(int socket_fd, std::string& response, ContentConsumer& consumer);
+        bool   ensure_recv_buffer(size_t nbytes_total);
+        int    get_remaining_time(void) const;
         static int    parse_http_response(const char* buffer, size_t buffer_size, std::string& http_response, std::string& http_content);
         static int    get_http_return_code(const char* buffer, size_t buffer_size);
         static size_t get_content_length(const char* buffer, size_t buffer_size);
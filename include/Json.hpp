@@ -70,10 +70,39 @@
 
             size_t value_extra;  /* how much extra space to allocate for values? */
 
+            /* Limits against corrupt or malicious input (leave 0 for no limit).
+             * max_depth is the maximum nesting depth of objects and arrays;
+             * max_elements is the maximum number of values in the document.
+             */
+            unsigned int max_depth;
+            size_t max_elements;
+
         } json_settings;
 
 #define json_enable_comments  0x01
 
+/* Check the syntax only: json_parse_ex does not allocate anything and
+ * returns a pointer to json_value_none if the text is well-formed, or NULL
+ * otherwise. The returned pointer may be passed to json_value_free, which
+ * ignores it. The nesting depth is limited to JSON_VALIDATE_MAX_DEPTH.
+ */
+#define json_validate_only    0x02
+
+#ifndef JSON_VALIDATE_MAX_DEPTH
+#define JSON_VALIDATE_MAX_DEPTH 64
+#endif
+
+/* Index objects with at least JSON_INDEX_MIN_LENGTH entries by a hash table
+ * once the document has been parsed, see json_object_index_ex.
+ */
+#define json_index_objects    0x04
+
+/* Objects with at least this many entries get a hash index, if requested.
+ */
+#ifndef JSON_INDEX_MIN_LENGTH
+#define JSON_INDEX_MIN_LENGTH 16
+#endif
+
         typedef enum
         {
             json_none,
@@ -98,6 +127,25 @@
 
         } json_object_entry;
 
+        typedef enum
+        {
+            json_match_exact,       /* names are byte-wise identical */
+            json_match_nocase,      /* names differ in ASCII case only */
+            json_match_nodigits     /* as json_match_nocase, trailing digits are ignored, e.g. "Power1" matches "POWER" */
+
+        } json_match;
+
+        struct _json_value;
+        struct _json_object_index;
+
+        /* Find the first entry of an object whose name matches; large objects
+         * are looked up through their hash index, if they have one.
+         */
+        const json_object_entry* json_object_find(const struct _json_value* object,
+            const json_char* name,
+            unsigned int name_length,
+            json_match match);
+
         typedef struct _json_value
         {
             struct _json_value* parent;
@@ -160,6 +208,7 @@
             {
                 struct _json_value* next_alloc;
                 void* object_mem;
+                struct _json_object_index* object_index;  /* objects, once parsed */
 
             } _reserved;
 
@@ -196,14 +245,9 @@
 
             inline const struct _json_value& operator [] (const char* index) const
             {
-                if (type != json_object)
-                    return json_value_none;
-
-                for (unsigned int i = 0; i < u.object.length; ++i)
-                    if (!strcmp(u.object.values[i].name, index))
-                        return *u.object.values[i].value;
+                const json_object_entry* entry = json_object_find(this, index, (unsigned int)strlen(index), json_match_exact);
 
-                return json_value_none;
+                return (entry ? *entry->value : json_value_none);
             }
 
             inline operator const char* () const
@@ -271,6 +315,38 @@
 
         void json_value_free(json_value*);
 
+        /* Parse json text into a previously parsed tree. If the text has the
+         * same structure as the tree - the usual case when polling a device -
+         * the values are updated in place and previous is returned; nothing is
+         * allocated unless a string grows. Otherwise previous is freed and the
+         * text is parsed from scratch. previous may be NULL. On failure NULL is
+         * returned and previous has been freed in any case.
+         */
+        json_value* json_reparse_ex(json_settings* settings,
+            json_value* previous,
+            const json_char* json,
+            size_t length,
+            char* error);
+
+
+        /* Build the hash index of all objects in the tree with at least
+         * JSON_INDEX_MIN_LENGTH entries that have none yet; json_parse_ex,
+         * json_reparse_ex and json_stream_finish do this for json_index_objects.
+         * The index is owned by the object and released by json_value_free; its
+         * memory is not counted against max_memory. Returns 0 if an allocation
+         * failed; objects without an index are still found by a linear scan.
+         * Lookups through json_object_find only read the tree and its indexes,
+         * so a tree can be shared by concurrent readers once it is indexed.
+         */
+        int json_object_index_ex(json_settings* settings,
+            json_value* value);
+
+        /* Compare two names according to the given match mode.
+         */
+        int json_names_match(const json_char* name1, unsigned int length1,
+            const json_char* name2, unsigned int length2,
+            json_match match);
+
 
         /* Not usually necessary, unless you used a custom mem_alloc and now want to
          * use a custom mem_free.
@@ -279,6 +355,47 @@
             json_value*);
 
 
+        /* Resumable parser for json text that arrives in pieces, e.g. from a
+         * socket. json_stream_feed parses each piece as it arrives and keeps
+         * its state for the next call, so the text never has to be buffered as
+         * a whole. It reports json_stream_complete as soon as the root value is
+         * closed; json_stream_finish then hands out the tree, which has the same
+         * layout as one built by json_parse_ex and is released by
+         * json_value_free_ex. The stream can be reused for the next document.
+         * Comments are not supported.
+         */
+        typedef struct _json_stream json_stream;
+
+        typedef enum
+        {
+            json_stream_more,       /* the root value is still incomplete */
+            json_stream_complete,   /* the root value is complete */
+            json_stream_failed      /* syntax error or allocation failure */
+
+        } json_stream_status;
+
+        json_stream* json_stream_new(json_settings* settings);
+
+        /* Reset the stream and parse the next document into a previous tree: while the text
+         * has the same structure as the tree, its values are updated in place, as by
+         * json_reparse_ex; otherwise the matched part of it is kept and the rest is freed.
+         * The stream owns the previous tree from now on; it is either handed out by
+         * json_stream_finish, or freed.
+         */
+        void json_stream_reuse(json_stream* stream, json_value* previous);
+
+        json_stream_status json_stream_feed(json_stream* stream,
+            const json_char* json,
+            size_t length);
+
+        json_value* json_stream_finish(json_stream* stream,
+            char* error);
+
+        void json_stream_reset(json_stream* stream);
+
+        void json_stream_free(json_stream* stream);
+
+
 #ifdef __cplusplus
     } /* extern "C" */
 
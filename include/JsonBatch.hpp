@@ -0,0 +1,117 @@
+#ifndef __LIBTASMOTA_JSONBATCH_HPP__
+#define __LIBTASMOTA_JSONBATCH_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <JsonCpp.hpp>
+#include <PathInterner.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a columnar batch of flattened json leaves, e.g. for bulk ingestion of status reports into a time-series store.
+     * Each leaf of a flattened json tree becomes a row of (device id, path id, type, value). Key paths like "StatusSNS:ENERGY:Power"
+     * that have been interned by the global PathInterner, e.g. by a CompiledPath or by the consumer of the batch, get their global id,
+     * which is stable for the lifetime of the process and shared with other batches. Other key paths get a batch-local id, flagged by
+     * LOCAL_PATH and kept until the batch is cleared, so that flattening arbitrary documents never grows the global table. Within a
+     * batch, a key path keeps its id even if it is interned later. A batch constructed with intern_paths = true interns all key paths
+     * globally instead.
+     * Values are stored in the column matching their type: integers and booleans in the integer column, doubles in the double column and
+     * strings as offset and length into a shared character buffer. The columns of other types hold zero for that row.
+     * As clear() keeps the capacity of all columns, a batch that is reused for each poll does not grow its columns in steady state;
+     * only the batch-local key paths are recorded again after each clear().
+     */
+    class JsonBatch {
+
+    public:
+
+        /** Type tag of a row. */
+        enum ValueType {
+            VALUE_NULL    = 0,  ///< json null; no value column is used
+            VALUE_BOOLEAN = 1,  ///< boolean; 0 or 1 in the integer column
+            VALUE_INTEGER = 2,  ///< integer; in the integer column
+            VALUE_DOUBLE  = 3,  ///< double; in the double column
+            VALUE_STRING  = 4   ///< string; offset and length into the string buffer
+        };
+
+        static const PathInterner::PathId LOCAL_PATH = 0x80000000;  ///< flag of batch-local path ids; global ids never have this bit set
+
+        explicit JsonBatch(const bool intern_paths = false);
+
+        size_t flatten(const json_value* const json, const uint32_t device_id);
+        void   clear(void);
+
+        size_t size(void) const { return types.size(); }                                            ///< number of rows
+        const std::string&   getPath(const PathInterner::PathId path_id) const;
+        PathInterner::PathId findPath(const std::string& path) const;
+
+        const std::vector<uint32_t>& getDeviceIds(void) const     { return device_ids; }        ///< device id column
+        const std::vector<PathInterner::PathId>& getPathIds(void) const { return path_ids; }    ///< path id column
+        const std::vector<uint8_t>&  getTypes(void) const         { return types; }             ///< type tag column, see ValueType
+        const std::vector<int64_t>&  getIntegers(void) const      { return integers; }          ///< integer and boolean column
+        const std::vector<double>&   getDoubles(void) const       { return doubles; }           ///< double column
+        const std::vector<uint32_t>& getStringOffsets(void) const { return string_offsets; }    ///< offset column into the string buffer
+        const std::vector<uint32_t>& getStringLengths(void) const { return string_lengths; }    ///< length column into the string buffer
+        const std::string&           getStringBuffer(void) const  { return string_buffer; }     ///< string values, concatenated without separators
+
+        JsonCpp::StringView getString(const size_t row) const;
+
+    protected:
+
+        std::vector<uint32_t> device_ids;
+        std::vector<PathInterner::PathId> path_ids;
+        std::vector<uint8_t>  types;
+        std::vector<int64_t>  integers;
+        std::vector<double>   doubles;
+        std::vector<uint32_t> string_offsets;
+        std::vector<uint32_t> string_lengths;
+        std::string           string_buffer;
+
+        std::string path_buffer;    // key path of the current node during flatten()
+        bool        intern_paths;   // true to intern all key paths globally
+        std::vector<std::string> local_paths;                             // local path id & ~LOCAL_PATH => key path
+        std::unordered_map<std::string, PathInterner::PathId> local_ids;  // key path => local path id
+
+        PathInterner::PathId getPathId(const std::string& path);
+
+        void     traverse(const json_value* const value, const uint32_t device_id);
+        void     appendRow(const json_value* const value, const uint32_t device_id);
+    };
+
+}   // namespace libtasmota
+
+#endif
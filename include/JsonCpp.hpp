@@ -31,6 +31,7 @@
 
 #include <Json.hpp>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <utility>
@@ -52,26 +53,40 @@ namespace libralfogit {
         class JsonValue;
         class JsonNamedValue;
 
+        /** Class encapsulating a non-owning view onto a character sequence, typically a name or string inside the json tree. */
+        class StringView {
+        protected:
+            const char* ptr;        ///< pointer to the first character; not necessarily null terminated
+            size_t      length;     ///< number of characters
+        public:
+            StringView(void) : ptr(""), length(0) {}                                                                 /// Constructor for an empty view.
+            StringView(const char* const _ptr, const size_t _length) : ptr(_ptr), length(_length) {}                 /// Constructor. @param pointer and length of the character sequence
+            StringView(const char* const str) : ptr(str), length(str != NULL ? strlen(str) : 0) {}                   /// Constructor. @param null terminated string
+            StringView(const std::string& str) : ptr(str.data()), length(str.length()) {}                            /// Constructor. @param string; it must outlive the view
+            const char* data(void) const { return ptr; }                                                             ///< Pointer to the first character.
+            size_t      size(void) const { return length; }                                                          ///< Number of characters.
+            bool        empty(void) const { return length == 0; }                                                    ///< True, if the view is empty.
+            char        operator[](size_t index) const { return ptr[index]; }                                        ///< Character at the given index.
+            bool operator==(const StringView& other) const { return length == other.length && memcmp(ptr, other.ptr, length) == 0; }  ///< Byte-wise equality.
+            bool operator!=(const StringView& other) const { return !operator==(other); }                            ///< Byte-wise inequality.
+            operator std::string(void) const { return std::string(ptr, length); }                                    ///< Copy the viewed characters into a string.
+        };
+
         /** Class encapsulating a json object value. */
         class JsonObject {
         protected:
-            json_object_entry* value;   ///< pointer to an array of json_object_entry elements
-            unsigned int       length;  ///< number of json_object_entry elements in the array
+            const json_value* object;   ///< pointer to the json object value in the json tree, or NULL
         public:
-            JsonObject(const json_value* const jvalue = NULL) : value(NULL), length(0) {                            /// Constructor. @param pointer to the json_object_entry in the json tree
-                if (jvalue != NULL && jvalue->type == json_object) {
-                    value  = jvalue->u.object.values;
-                    length = jvalue->u.object.length;
-                }
-            }
+            JsonObject(const json_value* const jvalue = NULL) : object(jvalue != NULL && jvalue->type == json_object ? jvalue : NULL) {}   /// Constructor. @param pointer to the json_value in the json tree
             JsonObject(const json_object_entry* const entry) : JsonObject((entry != NULL ? entry->value : NULL)) {} /// Constructor. @param pointer to the json_object_entry in the json tree
-            const json_object_entry* const c_ptr   (void) const { return value; }                                   ///< Pointer to child elements in this json object. 
-            const unsigned int             c_length(void) const { return length; }                                  ///< Number of child elements in this json object.
+            const json_value*              c_value (void) const { return object; }                                  ///< Pointer to this json object in the json tree.
+            const json_object_entry*       c_ptr   (void) const { return object != NULL ? object->u.object.values : NULL; }   ///< Pointer to child elements in this json object. 
+            unsigned int                   c_length(void) const { return object != NULL ? object->u.object.length : 0; }      ///< Number of child elements in this json object.
 
-            size_t               size      (void)                   const { return length; }                        ///< Number of key value pairs in  this json object.
-            const JsonNamedValue operator[](size_t index)           const { return JsonNamedValue(&value[index]); } ///< Array index operator [] for this json object.
+            size_t               size      (void)                   const { return c_length(); }                    ///< Number of key value pairs in  this json object.
+            const JsonNamedValue operator[](size_t index)           const { return JsonNamedValue(&c_ptr()[index]); } ///< Array index operator [] for this json object.
             const JsonValue      operator[](const std::string& key) const {                                         ///< Array dictionary operator [] for this json object.
-                return getValue(value, length, key, NULL);
+                return findValue(*this, key, json_match_exact);
             }
             operator std::string() const {                                                                          ///< String representation for this json object.
                 std::string result = "{";
@@ -83,15 +98,15 @@ namespace libralfogit {
 
             class iterator {
             public:
-                iterator(json_object_entry* _ptr) : ptr(_ptr) {}
+                iterator(const json_object_entry* _ptr) : ptr(_ptr) {}
                 iterator operator++() { ++ptr; return *this; }
                 bool operator!=(const iterator& other) const { return ptr != other.ptr; }
                 const JsonNamedValue operator*() const { return JsonNamedValue(ptr); }
             private:
-                json_object_entry* ptr;
+                const json_object_entry* ptr;
             };
-            iterator begin() const { return iterator(value); }
-            iterator end() const { return iterator(value + length); }
+            iterator begin() const { return iterator(c_ptr()); }
+            iterator end() const { return iterator(c_ptr() + c_length()); }
         };
 
         /** Class encapsulating a json array value. */
@@ -107,8 +122,8 @@ namespace libralfogit {
                 }
             }
             JsonArray(const json_object_entry* const entry = NULL) : JsonArray((entry != NULL ? entry->value : NULL)) {} /// Constructor. @param pointer to the json_object_entry in the json tree
-            const json_value** const c_ptr   (void) const { return (const json_value** const)value; }   ///< Pointer to values in this json array.
-            const unsigned int       c_length(void) const { return length; }                            ///< Get number of child elements for this json object.
+            const json_value**       c_ptr   (void) const { return (const json_value**)value; }         ///< Pointer to values in this json array.
+            unsigned int             c_length(void) const { return length; }                            ///< Get number of child elements for this json object.
 
             size_t            size(void)               const { return length; }                         ///< Number of values in this json array.
             const JsonValue   operator[](size_t index) const { return JsonValue((value[index])); }      ///< Array index operator [] for this json array.
@@ -136,15 +151,16 @@ namespace libralfogit {
         /** Class encapsulating a json string value. */
         class JsonString {
         protected:
-            std::string value;                                                      ///< json string value converted from the json_object_entry
+            StringView value;                                                       ///< view onto the json string value inside the json tree
         public:
-            JsonString(const json_value* const jvalue = NULL) : value("INVALID") {  /// Constructor. @param pointer to the json_value in the json tree
+            JsonString(const json_value* const jvalue = NULL) : value("INVALID", 7) {   /// Constructor. @param pointer to the json_value in the json tree
                 if (jvalue != NULL && jvalue->type == json_string) {
-                    value = std::string(jvalue->u.string.ptr, jvalue->u.string.length);
+                    value = StringView(jvalue->u.string.ptr, jvalue->u.string.length);
                 }
             }
             JsonString(const json_object_entry* const entry) : JsonString((entry != NULL ? entry->value : NULL)) {}
-            const    std::string& getValue(void) const { return value; }            ///< Get string value for this json string.
+            std::string       getValue    (void) const { return value; }            ///< Get string value for this json string.
+            StringView        getValueView(void) const { return value; }            ///< Get string value for this json string without copying it.
             operator std::string          (void) const { return getValue(); }       ///< Get string value for this json string. Same as getValue().
         };
 
@@ -205,66 +221,50 @@ namespace libralfogit {
 
         /**
         * Class encapsulating a json value.
-        * It holds instances of all possible json value types; only one of them is valid at any given time.
+        * It is a handle holding a single pointer into the json tree; the typed accessors are dispatched on the type of the json value.
         */
         class JsonValue {
         protected:
-            JsonObject  value_object;
-            JsonArray   value_array;
-            JsonString  value_string;
-            JsonBool    value_boolean;
-            JsonInt     value_int;
-            JsonDouble  value_double;
-            json_type   type;
+            const json_value* value;    ///< pointer to the json_value in the json tree, or NULL
         public:
-            JsonValue(const json_value* const jvalue = NULL) :
-                value_object(jvalue),
-                value_array(jvalue),
-                value_string(jvalue),
-                value_boolean(jvalue),
-                value_int(jvalue),
-                value_double(jvalue),
-                type(jvalue != NULL ? jvalue->type : json_none) {}
-            JsonValue(const json_object_entry* const jvalue = NULL) :
-                value_object(jvalue),
-                value_array(jvalue),
-                value_string(jvalue),
-                value_boolean(jvalue),
-                value_int(jvalue),
-                value_double(jvalue),
-                type(jvalue != NULL ? json_object : json_none) {}
-
-            const json_type    getType (void) const { return type; }           ///< Get type of this json value.
-
-            const JsonObject&  asObject(void) const { return value_object; }   ///< Get object value of this json value.
-            const JsonArray&   asArray (void) const { return value_array; }    ///< Get array value of this json value.
-            const JsonString&  asString(void) const { return value_string; }   ///< Get string value of this json value.
-            const JsonBool&    asBool  (void) const { return value_boolean; }  ///< Get boolean value of this json value.
-            const JsonInt&     asInt   (void) const { return value_int; }      ///< Get integer value of this json value.
-            const JsonDouble&  asDouble(void) const { return value_double; }   ///< Get double value of this json value.
-
-            const bool isNull  (void) const { return type == json_null; }
-            const bool isNone  (void) const { return type == json_none; }
-            const bool isObject(void) const { return type == json_object; }
-            const bool isArray (void) const { return type == json_array; }
-            const bool isString(void) const { return type == json_string; }
-            const bool isBool  (void) const { return type == json_boolean; }
-            const bool isInt   (void) const { return type == json_integer; }
-            const bool isDouble(void) const { return type == json_double; }
+            JsonValue(const json_value* const jvalue = NULL) :                      /// Constructor. @param pointer to the json_value in the json tree
+                value(jvalue) {}
+            JsonValue(const json_object_entry* const jvalue = NULL) :               /// Constructor. @param pointer to the json_object_entry in the json tree
+                value(jvalue != NULL ? jvalue->value : NULL) {}
+
+            json_type          getType (void) const { return value != NULL ? value->type : json_none; }  ///< Get type of this json value.
+            const json_value*  c_ptr   (void) const { return value; }               ///< Pointer to the json_value in the json tree.
+
+            const JsonObject   asObject(void) const { return JsonObject(value); }   ///< Get object value of this json value.
+            const JsonArray    asArray (void) const { return JsonArray(value); }    ///< Get array value of this json value.
+            const JsonString   asString(void) const { return JsonString(value); }   ///< Get string value of this json value.
+            const JsonBool     asBool  (void) const { return JsonBool(value); }     ///< Get boolean value of this json value.
+            const JsonInt      asInt   (void) const { return JsonInt(value); }      ///< Get integer value of this json value.
+            const JsonDouble   asDouble(void) const { return JsonDouble(value); }   ///< Get double value of this json value.
+
+            bool isNull  (void) const { return getType() == json_null; }
+            bool isNone  (void) const { return getType() == json_none; }
+            bool isObject(void) const { return getType() == json_object; }
+            bool isArray (void) const { return getType() == json_array; }
+            bool isString(void) const { return getType() == json_string; }
+            bool isBool  (void) const { return getType() == json_boolean; }
+            bool isInt   (void) const { return getType() == json_integer; }
+            bool isDouble(void) const { return getType() == json_double; }
 
             /**
             * Get the value of this json name value pair converted to a string.
             * @return the value as string
             */
             operator std::string() const { 
-                switch (type) {
-                case json_object:  return std::string(value_object);
-                case json_string:  return std::string(value_string);
-                case json_boolean: return std::string(value_boolean);
-                case json_integer: return std::string(value_int);
-                case json_double:  return std::string(value_double);
-                case json_array:   return std::string(value_array);
+                switch (getType()) {
+                case json_object:  return std::string(asObject());
+                case json_string:  return std::string(asString());
+                case json_boolean: return std::string(asBool());
+                case json_integer: return std::string(asInt());
+                case json_double:  return std::string(asDouble());
+                case json_array:   return std::string(asArray());
                 case json_null:    return "null";
+                default:           break;
                 }
                 return "INVALID";
             }
@@ -272,24 +272,21 @@ namespace libralfogit {
 
         /**
         * Class encapsulating a json name value pair.
-        * It holds instances of all possible json value types; only one of them is valid at any given time.
+        * It is a handle holding a single pointer to the json_object_entry in the json tree.
         */
         class JsonNamedValue : public JsonValue {
         protected:
-            std::string name;
+            const json_object_entry* entry;     ///< pointer to the json_object_entry in the json tree, or NULL
         public:
-            JsonNamedValue(const json_object_entry* const entry = NULL) :
-                JsonValue(entry != NULL ? entry->value : NULL) {
-                if (entry != NULL && entry->name != NULL) {
-                    name = std::string(entry->name, entry->name_length);
-                }
-                else {
-                    name = "INVALID";
-                }
+            JsonNamedValue(const json_object_entry* const _entry = NULL) :
+                JsonValue(_entry != NULL ? _entry->value : NULL),
+                entry(_entry) {}
+            const    std::string getName    (void) const { return getNameView(); }  ///< Get a copy of the name of this json named value.
+            const    StringView  getNameView(void) const {                          ///< Get the name of this json named value without copying it.
+                return (entry != NULL && entry->name != NULL ? StringView(entry->name, entry->name_length) : StringView("INVALID", 7));
             }
-            const    std::string getName (void) const { return name; }
-            const    JsonValue   getValue(void) const { return JsonValue(*this); }
-            operator std::string         (void) const { return getName() + ":" + JsonValue::operator std::string(); }
+            const    JsonValue   getValue   (void) const { return JsonValue(value); }
+            operator std::string            (void) const { return getName() + ":" + JsonValue::operator std::string(); }
         };
 
         /// Type definition for a vector of json named value pairs
@@ -341,6 +338,7 @@ namespace libralfogit {
 
 
         typedef bool (*compare)(const std::string& lhs, const std::string& rhs);
+        typedef bool (*compare_view)(const StringView& lhs, const StringView& rhs);
 
         /**
         * Get a json named value from the given json tree level.
@@ -351,11 +349,13 @@ namespace libralfogit {
         * @return a json named value pair, or an empty named value pair
         */
         static JsonNamedValue getValue(const json_object_entry* const elements, const size_t num_elements, const std::string& name, compare name_comparator = NULL) {
+            if (name_comparator == NULL) {
+                return findValue(elements, num_elements, name, NULL);
+            }
             if (elements != NULL) {
                 for (size_t i = 0; i < num_elements; ++i) {
                     std::string element_name(elements[i].name, elements[i].name_length);
-                    if (name_comparator == NULL && element_name == name ||
-                        name_comparator != NULL && name_comparator(element_name, name) == true) {
+                    if (name_comparator(element_name, name) == true) {
                         return JsonNamedValue(&elements[i]);
                     }
                 }
@@ -371,17 +371,57 @@ namespace libralfogit {
         * @return a json named value pair, or an empty named value pair
         */
         static JsonNamedValue getValue(const JsonObject& object, const std::string& name, compare name_comparator = NULL) {
-            for (const auto element : object) {
-                std::string element_name(element.getName());
-                if (name_comparator == NULL && element_name == name ||
-                    name_comparator != NULL && name_comparator(element_name, name) == true) {
-                    return element;
+            return getValue(object.c_ptr(), object.c_length(), name, name_comparator);
+        }
+
+        /**
+        * Find a json named value in the given json tree level; names are compared in place, nothing is allocated.
+        * @param elements  pointer to an array of json object entries
+        * @param num_elements number of array elements
+        * @param name the name of the json named value pair to search for
+        * @param name_comparator a function pointer to an optional name comparater method, or NULL for byte-wise comparison
+        * @return a json named value pair, or an empty named value pair
+        */
+        static JsonNamedValue findValue(const json_object_entry* const elements, const size_t num_elements, const StringView& name, compare_view name_comparator = NULL) {
+            if (elements != NULL) {
+                for (size_t i = 0; i < num_elements; ++i) {
+                    const StringView element_name(elements[i].name, elements[i].name_length);
+                    if ((name_comparator == NULL && element_name == name) ||
+                        (name_comparator != NULL && name_comparator(element_name, name) == true)) {
+                        return JsonNamedValue(&elements[i]);
+                    }
                 }
             }
             return JsonNamedValue(NULL);
         }
+
+        /**
+        * Find a json named value in the given json object; names are compared in place, nothing is allocated.
+        * @param object  the json object
+        * @param name the name of the json named value pair to search for
+        * @param name_comparator a function pointer to an optional name comparater method, or NULL for byte-wise comparison
+        * @return a json named value pair, or an empty named value pair
+        */
+        static JsonNamedValue findValue(const JsonObject& object, const StringView& name, compare_view name_comparator = NULL) {
+            if (name_comparator == NULL) {
+                return findValue(object, name, json_match_exact);
+            }
+            return findValue(object.c_ptr(), object.c_length(), name, name_comparator);
+        }
+
+        /**
+        * Find a json named value in the given json object using one of the built-in name matching modes.
+        * Large json objects are looked up through their hash index, if the tree has been parsed with json_index_objects.
+        * @param object  the json object
+        * @param name the name of the json named value pair to search for
+        * @param match the name matching mode, e.g. json_match_nocase
+        * @return a json named value pair, or an empty named value pair
+        */
+        static JsonNamedValue findValue(const JsonObject& object, const StringView& name, const json_match match) {
+            return JsonNamedValue(json_object_find(object.c_value(), name.data(), (unsigned int)name.size(), match));
+        }
     };
 
-}   // namespace libphoscon
+}   // namespace libtasmota
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef __LIBTASMOTA_JSONDIFF_HPP__
+#define __LIBTASMOTA_JSONDIFF_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <JsonCpp.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a structural diff between two json trees, e.g. two successive status reports of a device.
+     * Both trees are walked simultaneously. Object entries are aligned by position as long as the names at the same
+     * position match, which is the usual case for successive reports; otherwise they are looked up by name.
+     * Array elements are aligned by index. Changed leaves are reported with their key path, e.g. "StatusSNS:ENERGY:Power".
+     */
+    class JsonDiff {
+
+    public:
+
+        /** Type of a change. */
+        enum ChangeType {
+            CHANGE_MODIFIED,    ///< the value has changed
+            CHANGE_ADDED,       ///< the value exists in the new tree only
+            CHANGE_REMOVED      ///< the value exists in the old tree only
+        };
+
+        /** A changed leaf; the values point into the compared json trees. */
+        struct Change {
+            ChangeType         type;        ///< type of the change
+            std::string        path;        ///< key path of the changed leaf, e.g. "StatusSNS:ENERGY:Power"
+            JsonCpp::JsonValue old_value;   ///< value in the old tree; json_none if the leaf has been added
+            JsonCpp::JsonValue new_value;   ///< value in the new tree; json_none if the leaf has been removed
+            Change(ChangeType _type, const std::string& _path, const json_value* _old, const json_value* _new) :
+                type(_type), path(_path), old_value(_old), new_value(_new) {}
+        };
+        typedef std::vector<Change> ChangeVector;
+
+        static size_t diff(const json_value* const old_tree, const json_value* const new_tree, ChangeVector& changes);
+        static bool   equalValues(const json_value* const value1, const json_value* const value2);
+
+    protected:
+
+        static void compare(const json_value* const old_value, const json_value* const new_value, std::string& path, ChangeVector& changes);
+        static void report(const ChangeType type, const json_value* const value, std::string& path, ChangeVector& changes);
+        static void appendName(std::string& path, const json_char* name, const unsigned int name_length);
+        static void appendIndex(std::string& path, const unsigned int index);
+    };
+
+}   // namespace libtasmota
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef __LIBTASMOTA_JSONWRITER_HPP__
+#define __LIBTASMOTA_JSONWRITER_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <cstdint>
+#include <Json.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a streaming json writer, e.g. to build Rule, Template or Backlog payloads.
+     * The json text is appended to a caller provided buffer; the buffer is never cleared by the writer, so it can be
+     * reused across payloads without reallocation. Separators between values are inserted automatically:
+     *
+     *     std::string buffer;
+     *     JsonWriter writer(buffer);
+     *     writer.beginObject().writeKey("NAME").writeString("Plug").writeKey("GPIO").beginArray().writeInteger(0).endArray().endObject();
+     *     // buffer == "{\"NAME\":\"Plug\",\"GPIO\":[0]}"
+     *
+     * The writer does not validate the nesting of objects and arrays; it is the responsibility of the caller.
+     * Doubles that are not finite are written as null, as json has no representation for them.
+     */
+    class JsonWriter {
+
+    public:
+
+        explicit JsonWriter(std::string& buffer);
+
+        JsonWriter& beginObject(void);
+        JsonWriter& endObject(void);
+        JsonWriter& beginArray(void);
+        JsonWriter& endArray(void);
+
+        JsonWriter& writeKey    (const char* key, const size_t length);
+        JsonWriter& writeKey    (const std::string& key) { return writeKey(key.data(), key.length()); }      ///< Write an object key.
+        JsonWriter& writeKey    (const char* key);
+        JsonWriter& writeString (const char* value, const size_t length);
+        JsonWriter& writeString (const std::string& value) { return writeString(value.data(), value.length()); }  ///< Write a string value.
+        JsonWriter& writeString (const char* value);
+        JsonWriter& writeInteger(const int64_t value);
+        JsonWriter& writeDouble (const double value);
+        JsonWriter& writeBool   (const bool value);
+        JsonWriter& writeNull   (void);
+        JsonWriter& writeJson   (const json_value* const value);
+
+        std::string& getBuffer(void) const { return buffer; }    ///< Get the buffer the json text is appended to.
+
+        static void appendInteger(std::string& buffer, const int64_t value);
+        static void appendDouble (std::string& buffer, const double value);
+        static void appendEscaped(std::string& buffer, const char* value, const size_t length);
+
+    protected:
+
+        std::string& buffer;
+        bool         need_comma;    // a value has been written at the current nesting level
+        bool         after_key;     // a key has been written and its value is pending
+
+        void separate(void);
+    };
+
+}   // namespace libtasmota
+
+#endif
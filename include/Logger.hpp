@@ -68,7 +68,7 @@ namespace libtasmota {
          *  @param msg The message string
          *  @param level The log level of the message string
          */
-        virtual void operator()(const std::wstring& msg, const LogLevel& level) {}
+        virtual void operator()(const std::wstring& /*msg*/, const LogLevel& /*level*/) {}
     };
 
 
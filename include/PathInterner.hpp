@@ -0,0 +1,107 @@
+#ifndef __LIBTASMOTA_PATHINTERNER_HPP__
+#define __LIBTASMOTA_PATHINTERNER_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a global, thread-safe interning table for key paths like "StatusSNS:ENERGY:Total".
+     * Each distinct key path is stored once and identified by a small integer id, so that samples can carry
+     * and compare path ids instead of path strings. Ids are assigned in ascending order starting at 0 and stay
+     * valid for the lifetime of the process; interned paths are never removed.
+     * Lookups of paths that are already interned, and the mapping from id to path, are lock-free. Interning a
+     * new path takes a mutex. The hash table is replaced by a larger copy when it fills up; replaced tables are
+     * kept until the interner is destroyed, so that concurrent readers never see released memory.
+     */
+    class PathInterner {
+
+    public:
+
+        typedef uint32_t PathId;
+        static const PathId INVALID_ID = 0xffffffff;    ///< id returned for paths that are not interned
+
+        static PathInterner& instance(void);
+
+        PathId intern(const char* path, const size_t length);
+        PathId intern(const std::string& path) { return intern(path.data(), path.length()); }     ///< Intern the given key path. @return its id
+        PathId find(const char* path, const size_t length) const;
+        PathId find(const std::string& path) const { return find(path.data(), path.length()); }   ///< Get the id of the given key path. @return its id, or INVALID_ID
+        const std::string& getPath(const PathId id) const;
+        size_t size(void) const { return count.load(std::memory_order_acquire); }                ///< number of interned key paths
+
+        PathInterner(void);
+        ~PathInterner(void);
+
+    protected:
+
+        /** Interned key path. */
+        struct Entry {
+            uint32_t    hash;
+            std::string path;
+        };
+
+        /** Open addressing hash table; a slot holds the id + 1 of an entry, or 0 if it is empty. */
+        struct Table {
+            size_t mask;
+            std::atomic<uint32_t>* slots;
+        };
+
+        static const size_t CHUNK_BITS = 10;                // 1024 entries per chunk
+        static const size_t MAX_CHUNKS = 4096;              // up to 4M distinct key paths
+
+        std::atomic<Entry*>*    chunks[MAX_CHUNKS];         // id => entry; chunks are allocated on demand and never move
+        std::atomic<uint32_t>   count;                      // number of published entries
+        std::atomic<Table*>     table;                      // current hash table
+        std::vector<Table*>     retired_tables;             // replaced hash tables, released by the destructor
+        std::mutex              insert_mutex;               // serializes insertions
+
+        PathId lookup(const Table* const tab, const char* path, const size_t length, const uint32_t hash) const;
+        static Table* newTable(const size_t capacity);
+        static void   insertSlot(Table* const tab, const uint32_t hash, const PathId id);
+        static uint32_t hashPath(const char* path, const size_t length);
+
+    private:
+        PathInterner(const PathInterner&);
+        PathInterner& operator=(const PathInterner&);
+    };
+
+}   // namespace libtasmota
+
+#endif
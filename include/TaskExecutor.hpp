@@ -0,0 +1,101 @@
+#ifndef __LIBTASMOTA_TASKEXECUTOR_HPP__
+#define __LIBTASMOTA_TASKEXECUTOR_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a work-stealing thread pool, e.g. to run blocking device requests for many devices in parallel.
+     * Each worker thread owns a task deque guarded by its own mutex; there is no global queue lock. A worker takes tasks
+     * from the back of its own deque and, if that is empty, steals from the front of the deques of other workers. Tasks
+     * submitted from a worker thread go to the deque of that worker; tasks submitted from other threads are distributed
+     * round-robin. Idle workers sleep until a task is submitted.
+     * Tasks must not throw. Tasks that have not started when the executor is destroyed are discarded; the executor must not
+     * be destroyed from one of its own tasks.
+     */
+    class TaskExecutor {
+
+    public:
+
+        typedef std::function<void(void)> Task;
+
+        explicit TaskExecutor(const size_t num_workers = 0);
+        ~TaskExecutor(void);
+
+        size_t getNumWorkers(void) const { return workers.size(); }     ///< Get the number of worker threads.
+        bool   isWorkerThread(void) const;
+
+        void submit(const Task& task);
+        void parallelFor(const size_t count, const std::function<void(const size_t index)>& body, const size_t max_concurrency = 0);
+
+    protected:
+
+        /** Worker thread and its task deque. */
+        struct Worker {
+            std::mutex       mutex;     // guards tasks
+            std::deque<Task> tasks;
+            std::thread      thread;
+        };
+
+        std::vector<std::unique_ptr<Worker> > workers;
+        std::atomic<size_t>     pending;        // number of tasks in all deques
+        std::atomic<size_t>     sleepers;       // number of workers sleeping, or about to sleep, on sleep_cv
+        std::atomic<size_t>     next_worker;    // round-robin index for tasks submitted from other threads
+        std::atomic<bool>       stopping;
+        std::mutex              sleep_mutex;
+        std::condition_variable sleep_cv;
+
+        TaskExecutor(const TaskExecutor& other);              // not copyable
+        TaskExecutor& operator=(const TaskExecutor& other);   // not copyable
+
+        void run(const size_t index);
+        bool runOne(const size_t index);
+        bool pop(const size_t index, Task& task);
+        bool steal(const size_t index, Task& task);
+        void push(const size_t index, const Task& task);
+        bool getWorkerIndex(size_t& index) const;
+    };
+
+}   // namespace libtasmota
+
+#endif
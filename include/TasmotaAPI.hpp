@@ -32,7 +32,15 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <chrono>
 #include <JsonCpp.hpp>
+#include <HttpClient.hpp>
+#include <CompiledPath.hpp>
+#include <JsonDiff.hpp>
+#include <JsonBatch.hpp>
+#include <TasmotaBacklog.hpp>
+#include <PathInterner.hpp>
 
 #ifdef LIB_NAMESPACE
 namespace LIB_NAMESPACE {
@@ -47,27 +55,157 @@ namespace libtasmota {
 
     protected:
 
-        std::string host_url;
+        HttpEndpoint endpoint;              // device endpoint; the url is parsed once in the constructor
+        int          timeout;               // max time in milliseconds for a single http request
 
-        std::string assembleHttpUrl(const std::string& command, const std::string& value = "") const;
-        json_value* getJsonResponse(const std::string& command, std::string& http_status) const;
+        /** Cached status report, i.e. the response to a "Status 0" or a narrower "Status <n>" command. */
+        struct StatusReport {
+            json_value*  json;              // parsed tree; updated in place by the next response to the same command
+            const char*  command;           // percent-encoded command, e.g. "Status%2010"
+            std::string  content;           // http content, quoted by the http status string if a value is not found
+            int          code;              // http return code; the report is only used from cache if it is 200
+            std::chrono::steady_clock::time_point time;   // time when the report has been received
+            StatusReport(void) : json(NULL), command(NULL), code(0) {}
+        };
+
+        /** Top-level section of the status report that has a narrower status command, e.g. "StatusSNS" for "Status 10". */
+        struct StatusSection {
+            const char*  section;           // section name, i.e. the first segment of a key path
+            const char*  command;           // percent-encoded status command, e.g. "Status%2010"
+        };
+
+        static const size_t        num_status_sections = 12;
+        static const StatusSection status_sections[num_status_sections];
+
+        mutable std::mutex   status_mutex;  // serializes access to the status reports; it is not held during http requests
+        mutable StatusReport status_report; // "Status 0" report of the previous full read
+        mutable StatusReport section_reports[num_status_sections];  // narrower "Status <n>" reports of previous path reads, one per status section
+        mutable json_value*  previous_json; // "Status 0" tree before status_report; kept to detect changes
+        unsigned int         max_status_age;// max age in milliseconds of a status report to answer path reads from; 0 disables caching
+
+        /** Known device state for a command name, e.g. "ON" for "POWER". */
+        struct StateEntry {
+            std::string value;              // the value, e.g. "ON"
+            std::string result;             // the string setValue() returned for it
+            std::chrono::steady_clock::time_point time;   // time when the value has been received
+        };
+
+        mutable std::mutex   state_mutex;   // guards state_cache
+        mutable std::map<std::string, StateEntry> state_cache;  // known device state by upper-case command name
+        unsigned int         max_state_age; // max age in milliseconds of a known state to skip a redundant setValue(); 0 disables the state cache
+
+        static const unsigned int max_json_depth    = 32;       // nesting depth limit for json responses
+        static const size_t       max_json_elements = 65536;    // number of values limit for json responses
+        static const char* const  status_all;                   // "Status 0" command, requesting all sections
+
+        static std::string assembleTarget(const std::string& command, const std::string& value = "");
+        json_value* getJsonResponse(const std::string& command, std::string& content, int& http_return_code) const;
+        json_value* getJsonResponse(const std::string& command, std::string& content, int& http_return_code, json_value* previous) const;
+        json_value* getStatusResponse(std::unique_lock<std::mutex>& lock, int& http_return_code, const int max_age, const char* const command = status_all) const;
+        const StatusReport& getStatusReport(std::unique_lock<std::mutex>& lock, const char* const command, const int max_age) const;
+        StatusReport& getCachedReport(const char* const command) const;
+        void invalidateStatusReports(void) const;
+        static void setStatusReport(StatusReport& report, const char* const command, json_value* json, std::string& content, const int http_return_code);
+        static bool isFresh(const StatusReport& report, const char* const command, const long long max_age);
+        static const char* getStatusCommand(const JsonCpp::StringView& section);
+        static const char* getStatusCommand(const std::string& path);
+        static const char* getStatusCommand(const CompiledPath& path);
+        template<typename P> static const char* getStatusCommand(const std::vector<P>& paths);
+        template<typename T> int getTypedValue(const std::string& name, T& value) const;
+        static std::string getHttpStatus(const int http_return_code, const std::string& content);
+        static std::string getHttpStatus(const StatusReport& report);
+        static json_settings getJsonSettings(const int flags = 0);
         static std::string getValueFromJson(const json_value* const json, const std::string& name);
+        static const json_value* findValueInJson(const json_value* const json, const std::string& name);
+        static const json_value* findValueInResponse(const json_value* const json, const std::string& name);
+        bool findState(const std::string& name, const std::string& value, std::string& result) const;
+        void updateState(const std::string& name, const std::string& value, const std::string& result) const;
+        void updateState(const std::string& name, const json_value* const json) const;
+        void updateStateFromStatus(const json_value* const json) const;
+        void eraseState(const std::string& name) const;
+        static std::string getStateKey(const std::string& name);
+        static bool findValueInPath(const json_value* const json, const std::string& path, JsonCpp::JsonValue& leaf);
+        static int convertValue(const json_value* const json, double& value);
+        static int convertValue(const json_value* const json, int64_t& value);
+        static int convertValue(const json_value* const json, bool& value);
         static bool compareNames(const std::string& name1, const std::string& name2, const bool strict);
-        static std::vector<std::string> getPathSegments(const std::string& path);
+        static bool compareNames(const JsonCpp::StringView& name1, const JsonCpp::StringView& name2, const bool strict);
+        static bool getNextPathSegment(const std::string& path, size_t& offset, JsonCpp::StringView& segment);
 
     public:
 
+        /** Result codes of the typed get accessor methods; positive values are http return codes other than 200 OK. */
+        enum ValueResult {
+            VALUE_OK            =  0,   // the value has been found and converted
+            VALUE_NETWORK_ERROR = -1,   // the device cannot be reached
+            VALUE_INVALID_JSON  = -2,   // the response is not well-formed json
+            VALUE_NOT_FOUND     = -3,   // the response does not contain the name or path
+            VALUE_TYPE_MISMATCH = -4,   // the value cannot be converted to the requested type
+            VALUE_TIMEOUT       = -5    // the device did not answer within the deadline of a group command
+        };
+
+        /** Changed value in the status report of the device. */
+        struct ValueChange {
+            JsonDiff::ChangeType type;      // modified, added or removed
+            PathInterner::PathId path_id;   // id of the key path, if it has been interned, e.g. by a CompiledPath; PathInterner::INVALID_ID otherwise
+            std::string path;               // key path, e.g. "StatusSNS:ENERGY:Power"
+            std::string old_value;          // empty, if the value has been added
+            std::string new_value;          // empty, if the value has been removed
+            const std::string& getPath(void) const { return path; }
+        };
+
+        /** Max age argument of the path accessor methods to use the max age configured by setMaxStatusAge(). */
+        static const int DEFAULT_MAX_AGE = -1;
+
+        /** Result of a multi-path read or of a backlog command; result is VALUE_OK, a ValueResult error code, or the http return code if it is not 200 OK. */
+        struct PathValue {
+            int         result;         // result code for this path
+            std::string value;          // the value, if result is VALUE_OK
+            PathValue(void) : result(VALUE_NOT_FOUND) {}
+        };
+
         TasmotaAPI(const std::string& host_url);
-        ~TasmotaAPI(void) {}
+        TasmotaAPI(const TasmotaAPI& other);
+        ~TasmotaAPI(void);
+        TasmotaAPI& operator=(const TasmotaAPI& other);
 
         // Get accessor methods.
         std::string getValue(const std::string& name) const;                        // e.g. "Module"
-        std::string getValueFromPath(const std::string& path) const;                // e.g. "StatusSNS:ENERGY:Voltage"
+        std::string getValueFromPath(const std::string& path, const int max_age = DEFAULT_MAX_AGE) const;   // e.g. "StatusSNS:ENERGY:Voltage"
+        std::string getValueFromPath(const CompiledPath& path, const int max_age = DEFAULT_MAX_AGE) const;  // e.g. CompiledPath("StatusSNS:ENERGY:Voltage"), compiled once and reused
+        std::vector<std::pair<std::string, std::string> > getValuesFromPath(const CompiledPath& path, const int max_age = DEFAULT_MAX_AGE) const;  // e.g. "StatusSNS:ENERGY:{Power,Voltage,Current}"
+        std::vector<PathValue> getValuesFromPaths(const std::vector<std::string>& paths, const int max_age = DEFAULT_MAX_AGE) const;   // read several paths from one status report
+        std::vector<PathValue> getValuesFromPaths(const std::vector<CompiledPath>& paths, const int max_age = DEFAULT_MAX_AGE) const;  // e.g. compiled once and reused for each poll
+        int getDouble(const std::string& name, double& value) const;                // e.g. "Dimmer"; returns VALUE_OK or an error code
+        int getInt64(const std::string& name, int64_t& value) const;                // e.g. "Module"
+        int getBool(const std::string& name, bool& value) const;                    // e.g. "Power"; "ON" and "OFF" are converted
+        int getNumberFromPath(const CompiledPath& path, double& value, const int max_age = DEFAULT_MAX_AGE) const;  // e.g. CompiledPath("StatusSNS:ENERGY:Power")
+        std::vector<ValueChange> getChangedValues(void) const;                     // get the values that changed since the previous status report
+        size_t getStatusBatch(JsonBatch& batch, const uint32_t device_id, const int max_age = DEFAULT_MAX_AGE) const;  // append all values of the status report as rows to a columnar batch
+
+        // Status report snapshot; path reads are answered from the last status report if it is not older than the max age.
+        void setMaxStatusAge(const unsigned int max_age_ms) { max_status_age = max_age_ms; }  // e.g. 1000; 0 disables caching (default)
+        unsigned int getMaxStatusAge(void) const { return max_status_age; }
+
+        // Device state cache; setValue() is skipped if the device is known to be in the requested state for at most the max age.
+        void setMaxStateAge(const unsigned int max_age_ms) { max_state_age = max_age_ms; }    // e.g. 5000; 0 disables the state cache (default)
+        unsigned int getMaxStateAge(void) const { return max_state_age; }
+        void clearState(void);                                                      // forget the known device state
+
+        // Http request timeout, covering connect, send and receive.
+        void setTimeout(const int timeout_ms) { timeout = timeout_ms; }             // e.g. 2000; default 5000
+        int  getTimeout(void) const { return timeout; }
+        bool refresh(void);                                                         // read a new status report snapshot from the device
+
+        bool checkJsonResponse(const std::string& command) const;                   // check if the device answers the command with well-formed json, e.g. "Status"
 
         std::map<std::string, std::string> getModules(void) const;                  // get a vector of modules supported by the firmware
 
         // Set accessor methods.
         std::string setValue(const std::string& name, const std::string& value);    // e.g. "Power", can be used if name is well-known and documented
+        std::string setValue(const std::string& name, const std::string& value, const bool force);  // force: send even if the state is known
+        int setValue(const std::string& name, const std::string& value, std::string& result, const bool force = false);  // returns VALUE_OK or an error code
+        std::vector<PathValue> setValues(const TasmotaBacklog& backlog);             // e.g. "Power", "PowerOnState" and "TelePeriod", sent as backlog commands
 
     };
 
@@ -0,0 +1,84 @@
+#ifndef __LIBTASMOTA_TASMOTABACKLOG_HPP__
+#define __LIBTASMOTA_TASMOTABACKLOG_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a batch of set commands for a tasmota device, e.g. to provision Power, PowerOnState and TelePeriod at once.
+     * The commands are sent by TasmotaAPI::setValues() as tasmota "Backlog" commands, i.e. "Backlog Power ON; TelePeriod 60".
+     * As the device limits the length of a command and the number of commands in a backlog, the batch is split into as few
+     * backlog requests as possible that stay within both limits. As ';' characters separate backlog commands, a command
+     * whose value contains one is sent on its own as a plain command, e.g. a rule definition.
+     */
+    class TasmotaBacklog {
+
+    public:
+
+        static const size_t default_max_length   = 700;    ///< max length of a backlog command; the device input buffer holds 800 characters
+        static const size_t default_max_commands = 30;     ///< max number of commands in a backlog, see MAX_BACKLOG in the tasmota firmware
+
+        /** Range of commands [first, last) sent in a single backlog request. */
+        typedef std::pair<size_t, size_t> Range;
+
+        TasmotaBacklog(const size_t max_length = default_max_length, const size_t max_commands = default_max_commands);
+
+        TasmotaBacklog& add(const std::string& name, const std::string& value);
+        void            clear(void);
+
+        size_t             size   (void) const { return commands.size(); }                 ///< number of commands
+        bool               empty  (void) const { return commands.empty(); }                ///< true, if there are no commands
+        const std::string& getName(const size_t index) const { return commands[index].first; }    ///< command name, e.g. "Power"
+        const std::string& getValue(const size_t index) const { return commands[index].second; }  ///< command value, e.g. "ON"
+
+        void        split     (std::vector<Range>& ranges) const;
+        std::string getCommand(const Range& range) const;
+
+    protected:
+
+        std::vector<std::pair<std::string, std::string> > commands;
+        size_t max_length;
+        size_t max_commands;
+
+        size_t getLength(const size_t index) const;
+        bool   isSeparate(const size_t index) const;
+    };
+
+}   // namespace libtasmota
+
+#endif
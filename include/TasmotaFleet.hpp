@@ -0,0 +1,153 @@
+#ifndef __LIBTASMOTA_TASMOTAFLEET_HPP__
+#define __LIBTASMOTA_TASMOTAFLEET_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <cstdint>
+#include <TasmotaAPI.hpp>
+#include <CompiledPath.hpp>
+#include <TaskExecutor.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a scheduled poller for a fleet of tasmota devices.
+     * Each device is registered with its url, its poll interval and the key paths to read. The first poll of each device is
+     * placed at a random offset within its interval, and each following poll is delayed by a random jitter of up to a fraction
+     * of the interval, so that devices registered at the same time do not poll in lockstep. Polls are executed by a bounded
+     * work-stealing pool of worker threads, see TaskExecutor; each poll reads all paths of a device with a single request,
+     * see TasmotaAPI::getValuesFromPaths(). Results are delivered to a callback, which is invoked concurrently from the worker threads.
+     * A poll that is due while the previous poll of the same device is still running is skipped and counted as a missed deadline;
+     * so is a poll that does not finish within the poll interval.
+     */
+    class TasmotaFleet {
+
+    public:
+
+        typedef uint32_t DeviceId;
+
+        /** Result of a single poll of a device. */
+        struct PollResult {
+            DeviceId                           device_id;       ///< device id, as returned by addDevice()
+            std::vector<TasmotaAPI::PathValue> values;          ///< one result per registered path, in the order of the paths
+            long long                          lag;             ///< milliseconds from the scheduled time to the start of the poll
+            long long                          duration;        ///< milliseconds from the start to the end of the poll
+            bool                               missed_deadline; ///< true, if the poll did not finish within the poll interval
+        };
+        typedef std::function<void(const PollResult& result)> Callback;
+
+        /** Poll statistics of a device. */
+        struct DeviceStatistics {
+            uint64_t  polls;            ///< number of completed polls
+            uint64_t  missed_deadlines; ///< number of polls that finished late or were skipped
+            uint64_t  skipped;          ///< number of polls that were skipped, because the previous poll was still running
+            long long last_lag;         ///< lag of the last poll in milliseconds
+            long long max_lag;          ///< max lag of all polls in milliseconds
+            long long total_lag;        ///< sum of the lag of all polls in milliseconds; divide by polls to get the mean lag
+            DeviceStatistics(void) : polls(0), missed_deadlines(0), skipped(0), last_lag(0), max_lag(0), total_lag(0) {}
+        };
+
+        TasmotaFleet(const Callback& callback, const size_t num_workers = 0, const double max_jitter = 0.1);
+        ~TasmotaFleet(void);
+
+        DeviceId addDevice(const std::string& url, const unsigned int interval_ms, const std::vector<std::string>& paths);
+        bool     removeDevice(const DeviceId device_id);
+        size_t   size(void) const;
+        bool     getStatistics(const DeviceId device_id, DeviceStatistics& statistics) const;
+
+        void start(void);
+        bool stop(void);
+
+    protected:
+
+        typedef std::chrono::steady_clock Clock;
+
+        /** Registered device. */
+        struct Device {
+            DeviceId                  id;
+            TasmotaAPI                api;
+            std::vector<CompiledPath> paths;
+            Clock::duration           interval;
+            Clock::time_point         base;         // start of the current poll interval; advanced by one interval per poll
+            bool                      busy;         // true, while a poll of this device is queued or running
+            DeviceStatistics          statistics;
+            Device(const DeviceId _id, const std::string& url, const unsigned int interval_ms, const std::vector<std::string>& _paths);
+        };
+        typedef std::shared_ptr<Device> DevicePtr;
+
+        /** Scheduled poll; the schedule is a min-heap ordered by due time. */
+        struct Schedule {
+            Clock::time_point due;
+            DeviceId          device_id;
+            bool operator>(const Schedule& other) const { return due > other.due; }
+        };
+
+        /** Poll submitted to the executor. */
+        struct Task {
+            DevicePtr         device;
+            Clock::time_point due;
+        };
+
+        Callback                                callback;
+        size_t                                  num_workers;
+        double                                  max_jitter;
+
+        mutable std::mutex                      mutex;          // guards all members below
+        std::condition_variable                 schedule_cv;    // signalled when the schedule changes or the fleet is stopped
+        std::map<DeviceId, DevicePtr>           devices;
+        std::priority_queue<Schedule, std::vector<Schedule>, std::greater<Schedule> > schedule;
+        std::unique_ptr<TaskExecutor>           executor;       // worker threads executing the polls; exists while running
+        std::thread                             scheduler;
+        std::minstd_rand                        random;
+        DeviceId                                next_device_id;
+        bool                                    running;
+
+        Clock::time_point getDueTime(const Device& device);
+        void runScheduler(void);
+        void poll(const Task& task);
+    };
+
+}   // namespace libtasmota
+
+#endif
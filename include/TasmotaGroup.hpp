@@ -0,0 +1,81 @@
+#ifndef __LIBTASMOTA_TASMOTAGROUP_HPP__
+#define __LIBTASMOTA_TASMOTAGROUP_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <TasmotaAPI.hpp>
+#include <TaskExecutor.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a group of tasmota devices that receive the same command concurrently, e.g. "Power OFF" for demand response.
+     * A group command is sent to all devices in parallel on the given executor and returns when every device has answered or the
+     * overall deadline has passed. The http timeout of each request is limited to the time remaining until the deadline, and
+     * requests that have not started before the deadline are not sent at all, so the command returns shortly after the deadline.
+     * Group commands are serialized; the devices of a group are not shared with other threads.
+     */
+    class TasmotaGroup {
+
+    public:
+
+        /** Outcome of a group command for a single device. */
+        struct Outcome {
+            int         result;     ///< VALUE_OK, VALUE_TIMEOUT, VALUE_NOT_FOUND, ... or the http return code if it is not 200 OK, see TasmotaAPI::setValue()
+            std::string value;      ///< the value returned by the device, e.g. "OFF", or the error information
+            long long   duration;   ///< milliseconds from the start of the group command until the device answered
+            Outcome(void) : result(TasmotaAPI::VALUE_TIMEOUT), duration(0) {}
+        };
+
+        TasmotaGroup(TaskExecutor& executor, const size_t max_concurrency = 0);
+
+        size_t addDevice(const std::string& url);
+        size_t size(void) const;
+
+        std::vector<Outcome> setValue(const std::string& name, const std::string& value, const unsigned int deadline_ms);
+
+    protected:
+
+        TaskExecutor&                              executor;
+        size_t                                     max_concurrency;
+        mutable std::mutex                         mutex;      // serializes group commands
+        std::vector<std::unique_ptr<TasmotaAPI> >  devices;
+    };
+
+}   // namespace libtasmota
+
+#endif
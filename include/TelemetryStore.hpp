@@ -0,0 +1,126 @@
+#ifndef __LIBTASMOTA_TELEMETRYSTORE_HPP__
+#define __LIBTASMOTA_TELEMETRYSTORE_HPP__
+
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <JsonBatch.hpp>
+#include <PathInterner.hpp>
+
+#ifdef LIB_NAMESPACE
+namespace LIB_NAMESPACE {
+#else
+namespace libtasmota {
+#endif
+
+    /**
+     * Class implementing a fixed-memory store of numeric time series, e.g. the power, voltage and energy readings of many devices.
+     * A series is identified by a device id and an interned key path like "StatusSNS:ENERGY:Power". Each series is a ring buffer
+     * holding the latest capacity samples of (time, value); once it is full, each append overwrites the oldest sample.
+     * Samples are stored in struct-of-arrays layout: the times and the values of all series are kept in two contiguous arrays,
+     * with one block of capacity entries per series. Appends are O(1); window aggregates find the window by binary search and
+     * then run plain loops over at most two contiguous blocks of each array.
+     * The sample arrays grow with the number of series; their memory is bounded by max_series * capacity * 16 bytes, plus the
+     * series table. All methods are thread-safe.
+     */
+    class TelemetryStore {
+
+    public:
+
+        typedef uint32_t SeriesId;
+        static const SeriesId INVALID_SERIES = 0xffffffff;  ///< id returned if a series does not exist or cannot be added
+
+        /** Aggregates of the samples in a time window. */
+        struct Aggregate {
+            size_t  count;          ///< number of samples in the window
+            int64_t first_time;     ///< time of the first sample in the window
+            int64_t last_time;      ///< time of the last sample in the window
+            double  min;            ///< minimum value
+            double  max;            ///< maximum value
+            double  mean;           ///< arithmetic mean of the values
+            double  integral;       ///< trapezoidal integral of the values over time in seconds, e.g. Ws for values in W
+            Aggregate(void) : count(0), first_time(0), last_time(0), min(0.0), max(0.0), mean(0.0), integral(0.0) {}
+        };
+
+        TelemetryStore(const size_t samples_per_series, const size_t max_num_series);
+
+        SeriesId addSeries (const uint32_t device_id, const PathInterner::PathId path_id);
+        SeriesId findSeries(const uint32_t device_id, const PathInterner::PathId path_id) const;
+
+        bool   append(const SeriesId series_id, const int64_t time, const double value);
+        bool   append(const uint32_t device_id, const PathInterner::PathId path_id, const int64_t time, const double value);
+        size_t append(const JsonBatch& batch, const int64_t time);
+
+        size_t getSamples(const SeriesId series_id, const int64_t from_time, const int64_t to_time, std::vector<int64_t>& times, std::vector<double>& values) const;
+        bool   aggregate (const SeriesId series_id, const int64_t from_time, const int64_t to_time, Aggregate& result) const;
+
+        size_t size(const SeriesId series_id) const;
+        void   clear(void);
+
+        size_t getCapacity (void) const { return capacity; }       ///< maximum number of samples per series
+        size_t getMaxSeries(void) const { return max_series; }     ///< maximum number of series
+        size_t getNumSeries(void) const;
+
+    protected:
+
+        /** Series metadata; the samples are in times and values at [id * capacity, (id + 1) * capacity). */
+        struct Series {
+            uint32_t             device_id;
+            PathInterner::PathId path_id;
+            uint32_t             start;     ///< ring buffer index of the oldest sample
+            uint32_t             count;     ///< number of samples
+        };
+
+        const size_t capacity;
+        const size_t max_series;
+
+        std::vector<Series>  series;                        // series table, indexed by series id
+        std::vector<int64_t> times;                         // sample times, one block of capacity entries per series
+        std::vector<double>  values;                        // sample values, one block of capacity entries per series
+        std::unordered_map<uint64_t, SeriesId> series_ids;  // (device id, path id) => series id
+        mutable std::mutex   mutex;                         // guards all of the above
+
+        static uint64_t getKey(const uint32_t device_id, const PathInterner::PathId path_id) { return ((uint64_t)device_id << 32) | path_id; }
+        SeriesId addSeriesLocked(const uint32_t device_id, const PathInterner::PathId path_id);
+        bool     appendLocked(const SeriesId series_id, const int64_t time, const double value);
+        size_t   getIndex  (const Series& s, const size_t position) const { return (s.start + position) % capacity; }
+        size_t   lowerBound(const SeriesId series_id, const int64_t time) const;
+        size_t   upperBound(const SeriesId series_id, const int64_t time) const;
+
+    private:
+        TelemetryStore(const TelemetryStore&);
+        TelemetryStore& operator=(const TelemetryStore&);
+    };
+
+}   // namespace libtasmota
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <CompiledPath.hpp>
+#include <cstdio>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Default constructor; the path is empty and does not match anything.
+ */
+CompiledPath::CompiledPath(void) :
+    path(),
+    path_id(PathInterner::INVALID_ID),
+    segments(),
+    single(true)
+{}
+
+/**
+ * Constructor compiling the given key path.
+ * @param _path the key path, e.g. "StatusSNS:ENERGY:{Power,Voltage,Current}"
+ */
+CompiledPath::CompiledPath(const std::string& _path) :
+    path(_path),
+    path_id(PathInterner::instance().intern(_path)),
+    segments(),
+    single(true)
+{
+    compile();
+}
+
+
+/**
+ * Evaluate this path against the given json tree and collect all matches in a single traversal.
+ * Wildcard and slice matches are collected in json document order, alternatives in the order they are given in the path.
+ * @param json the json tree
+ * @param matches output - the matches are appended to this vector; the match values point into the json tree.
+ *                Concrete key paths are looked up in the PathInterner, but never added to it; a match only stores
+ *                a copy of its path if the path has not been interned, e.g. by compiling it
+ * @return the number of matches that have been appended
+ */
+size_t CompiledPath::evaluate(const json_value* const json, MatchVector& matches) const {
+    size_t num_matches = matches.size();
+    if (json != NULL && segments.size() > 0) {
+        std::string match_path;
+        match_path.reserve(path.length() + 16);
+        traverse(JsonCpp::JsonValue(json), 0, match_path, &matches, NULL);
+    }
+    return matches.size() - num_matches;
+}
+
+
+/**
+ * Evaluate this path against the given json tree and get the first match; the traversal stops at the first match.
+ * @param json the json tree
+ * @return the first matching json value, or a json value of type json_none if there is no match
+ */
+JsonCpp::JsonValue CompiledPath::evaluateFirst(const json_value* const json) const {
+    JsonCpp::JsonValue first((const json_value*)NULL);
+    if (json != NULL && segments.size() > 0) {
+        std::string match_path;
+        traverse(JsonCpp::JsonValue(json), 0, match_path, NULL, &first);
+    }
+    return first;
+}
+
+
+/**
+ * Split the key path into segments and classify each segment.
+ */
+void CompiledPath::compile(void) {
+    std::string::size_type index = 0;
+    while (index <= path.length()) {
+        std::string::size_type index_next = path.find(':', index);
+        if (index_next == std::string::npos) {
+            index_next = path.length();
+        }
+        std::string text = path.substr(index, index_next - index);
+        index = index_next + 1;
+        if (text.length() == 0) {
+            continue;
+        }
+
+        Segment segment;
+        segment.type    = SEGMENT_NAME;
+        segment.first   = 0;
+        segment.last    = 0;
+        segment.numeric = false;
+
+        std::string::size_type dots = text.find("..");
+        if (text == "*") {
+            segment.type = SEGMENT_WILDCARD;
+        }
+        else if (text.length() > 2 && text[0] == '{' && text[text.length() - 1] == '}') {
+            segment.type = SEGMENT_ALTERNATIVES;
+            std::string::size_type alt_index = 1;
+            while (alt_index < text.length()) {
+                std::string::size_type alt_next = text.find(',', alt_index);
+                if (alt_next == std::string::npos) {
+                    alt_next = text.length() - 1;
+                }
+                if (alt_next > alt_index) {
+                    segment.names.push_back(text.substr(alt_index, alt_next - alt_index));
+                }
+                alt_index = alt_next + 1;
+            }
+        }
+        else if (dots != std::string::npos && dots > 0 && parseIndex(text.substr(0, dots), segment.first) &&
+                (dots + 2 == text.length() || parseIndex(text.substr(dots + 2), segment.last))) {
+            segment.type = SEGMENT_SLICE;
+            if (dots + 2 == text.length()) {
+                segment.last = (unsigned int)-1;
+            }
+        }
+        else {
+            segment.numeric = parseIndex(text, segment.first);
+        }
+        if (segment.type != SEGMENT_ALTERNATIVES) {
+            segment.names.push_back(text);
+        }
+        if (segment.type != SEGMENT_NAME) {
+            single = false;
+        }
+        segments.push_back(segment);
+    }
+}
+
+
+/**
+ * Parse a non-negative decimal array index.
+ * @param text the text to parse
+ * @param index output - the array index
+ * @return true, if the text consists of decimal digits only
+ */
+bool CompiledPath::parseIndex(const std::string& text, unsigned int& index) {
+    if (text.length() == 0 || text.length() > 9) {
+        return false;
+    }
+    index = 0;
+    for (size_t i = 0; i < text.length(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        index = index * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+
+/**
+ * Recursively traverse the json tree along the compiled path segments.
+ * @param node the current json node
+ * @param segment_index index of the path segment to be matched against the children of node
+ * @param match_path the concrete key path of node; it is only maintained if matches is not NULL
+ * @param matches output - if not NULL, all matches are appended
+ * @param first output - if not NULL, the first match is assigned and the traversal stops
+ */
+void CompiledPath::traverse(const JsonCpp::JsonValue& node, const size_t segment_index, std::string& match_path, MatchVector* matches, JsonCpp::JsonValue* first) const {
+    if (first != NULL && first->isNone() == false) {
+        return;
+    }
+    if (segment_index == segments.size()) {
+        if (matches != NULL) {
+            const PathInterner::PathId match_id = PathInterner::instance().find(match_path);
+            matches->push_back(Match(match_id, (match_id != PathInterner::INVALID_ID ? std::string() : match_path), node));
+        }
+        if (first != NULL) {
+            *first = node;
+        }
+        return;
+    }
+
+    const Segment& segment = segments[segment_index];
+    const json_match match = (segment_index + 1 == segments.size() ? json_match_nodigits : json_match_nocase);
+    const size_t path_length = match_path.length();
+
+    if (node.isObject()) {
+        const JsonCpp::JsonObject object = node.asObject();
+        switch (segment.type) {
+        case SEGMENT_NAME:
+        case SEGMENT_ALTERNATIVES:
+            for (size_t i = 0; i < segment.names.size(); ++i) {
+                const std::string& name = segment.names[i];
+                const json_object_entry* entry = json_object_find(object.c_value(), name.data(), (unsigned int)name.length(), match);
+                if (entry != NULL) {
+                    if (matches != NULL) {
+                        match_path.append(path_length > 0 ? ":" : "").append(entry->name, entry->name_length);
+                    }
+                    traverse(JsonCpp::JsonValue(entry->value), segment_index + 1, match_path, matches, first);
+                    match_path.resize(path_length);
+                }
+            }
+            break;
+        case SEGMENT_WILDCARD:
+            for (const auto& element : object) {
+                if (matches != NULL) {
+                    const JsonCpp::StringView name = element.getNameView();
+                    match_path.append(path_length > 0 ? ":" : "").append(name.data(), name.size());
+                }
+                traverse(element.getValue(), segment_index + 1, match_path, matches, first);
+                match_path.resize(path_length);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    else if (node.isArray()) {
+        const JsonCpp::JsonArray array = node.asArray();
+        unsigned int begin = 0, end = 0;
+        switch (segment.type) {
+        case SEGMENT_NAME:
+            if (segment.numeric) {
+                begin = segment.first;
+                end   = segment.first + 1;
+            }
+            break;
+        case SEGMENT_WILDCARD:
+            end = (unsigned int)-1;
+            break;
+        case SEGMENT_SLICE:
+            begin = segment.first;
+            end   = segment.last;
+            break;
+        default:
+            break;
+        }
+        if (end > array.size()) {
+            end = (unsigned int)array.size();
+        }
+        for (unsigned int i = begin; i < end; ++i) {
+            if (matches != NULL) {
+                char buffer[16];
+                snprintf(buffer, sizeof(buffer), "%u", i);
+                match_path.append(path_length > 0 ? ":" : "").append(buffer);
+            }
+            traverse(array[i], segment_index + 1, match_path, matches, first);
+            match_path.resize(path_length);
+        }
+    }
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <EnergyAggregator.hpp>
+#include <thread>
+#include <cmath>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Constructor.
+ * @param max_groups the maximum number of groups, e.g. the number of sites plus the number of groups within the sites
+ * @param average_period_ms the time constant of the moving average of the power sum in milliseconds; 0 disables averaging
+ * @param max_sample_age_ms the max age of the latest power sample of a device in milliseconds, e.g. three poll intervals;
+ *        older samples drop out of the power sum, see expireDevices(); 0 keeps the latest sample of each device forever
+ */
+EnergyAggregator::EnergyAggregator(const size_t max_groups, const int64_t average_period_ms, const int64_t max_sample_age_ms) :
+    max_groups(max_groups),
+    average_period(average_period_ms),
+    max_sample_age(max_sample_age_ms > 0 ? max_sample_age_ms : 0),
+    slots(new GroupSlot[max_groups > 0 ? max_groups : 1]),
+    num_groups(0),
+    power_path(PathInterner::instance().intern("StatusSNS:ENERGY:Power")),
+    total_path(PathInterner::instance().intern("StatusSNS:ENERGY:Total"))
+{
+    for (size_t i = 0; i < max_groups; ++i) {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    groups.reserve(max_groups);
+}
+
+
+/**
+ * Add a group.
+ * @param name the group name, e.g. "Site 1"
+ * @return the group id, or INVALID_GROUP if the maximum number of groups is reached
+ */
+EnergyAggregator::GroupId EnergyAggregator::addGroup(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (groups.size() >= max_groups) {
+        return INVALID_GROUP;
+    }
+    const GroupId group_id = (GroupId)groups.size();
+    GroupState group = { 0, 0, 0.0, 0.0, 0.0, 0.0, 0, 0 };
+    groups.push_back(group);
+    slots[group_id].name = name;
+    publish(group_id);
+    num_groups.store(groups.size(), std::memory_order_release);
+    return group_id;
+}
+
+
+/**
+ * Add a device to a group; a device can belong to several groups, e.g. to a group of plugs and to a site.
+ * If the device has reported samples before, its latest power and energy counter are added to the group.
+ * @param device_id the device id
+ * @param group_id the group id
+ * @return true, if the device belongs to the group now; false, if the group does not exist
+ */
+bool EnergyAggregator::addDevice(const uint32_t device_id, const GroupId group_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (group_id >= groups.size()) {
+        return false;
+    }
+    DeviceState& device = devices[device_id];
+    for (size_t i = 0; i < device.groups.size(); ++i) {
+        if (device.groups[i] == group_id) {
+            return true;
+        }
+    }
+    if (device.groups.empty()) {
+        device.power_time = device.total_time = 0;
+        device.power = device.total = 0.0;
+        device.has_power = device.has_total = device.power_expired = false;
+    }
+    device.groups.push_back(group_id);
+    const bool counted = (device.has_power && !device.power_expired);
+    if (counted || device.has_total) {
+        GroupState& group = groups[group_id];
+        advanceAverage(group, group.time);
+        group.power += (counted ? device.power : 0.0);
+        group.total += (device.has_total ? device.total : 0.0);
+        group.devices += (counted ? 1 : 0);
+        group.average_power = (average_period > 0 ? group.average_power : group.power);
+        publish(group_id);
+    }
+    return true;
+}
+
+
+/**
+ * Remove a device from all its groups; its latest power and energy counter are subtracted from the groups.
+ * The energy integrated so far is kept.
+ * @param device_id the device id
+ */
+void EnergyAggregator::removeDevice(const uint32_t device_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint32_t, DeviceState>::iterator it = devices.find(device_id);
+    if (it == devices.end()) {
+        return;
+    }
+    const DeviceState& device = it->second;
+    const bool counted = (device.has_power && !device.power_expired);
+    for (size_t i = 0; i < device.groups.size(); ++i) {
+        GroupState& group = groups[device.groups[i]];
+        advanceAverage(group, group.time);
+        group.power -= (counted ? device.power : 0.0);
+        group.total -= (device.has_total ? device.total : 0.0);
+        group.devices -= (counted ? 1 : 0);
+        group.average_power = (average_period > 0 ? group.average_power : group.power);
+        publish(device.groups[i]);
+    }
+    devices.erase(it);
+}
+
+
+/**
+ * Aggregate the power and the energy counter of a device sample.
+ * @param sample the sample
+ */
+void EnergyAggregator::update(const Sample& sample) {
+    std::lock_guard<std::mutex> lock(mutex);
+    updatePowerLocked(sample.device_id, sample.time, sample.power);
+    updateTotalLocked(sample.device_id, sample.time, sample.total);
+}
+
+
+/**
+ * Aggregate a power sample of a device.
+ * @param device_id the device id
+ * @param time the sample time in milliseconds; times must not decrease for a device
+ * @param power the active power in W
+ * @return true, if the sample has been aggregated; false, if the device has not been added or the sample is older than the previous one
+ */
+bool EnergyAggregator::updatePower(const uint32_t device_id, const int64_t time, const double power) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return updatePowerLocked(device_id, time, power);
+}
+
+
+/**
+ * Aggregate an energy counter sample of a device.
+ * @param device_id the device id
+ * @param time the sample time in milliseconds; times must not decrease for a device
+ * @param total the energy counter in kWh
+ * @return true, if the sample has been aggregated; false, if the device has not been added or the sample is older than the previous one
+ */
+bool EnergyAggregator::updateTotal(const uint32_t device_id, const int64_t time, const double total) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return updateTotalLocked(device_id, time, total);
+}
+
+
+/**
+ * Aggregate the "StatusSNS:ENERGY:Power" and "StatusSNS:ENERGY:Total" rows of the given batch, e.g. flattened status reports of many devices.
+ * All other rows are ignored. Afterwards, devices whose latest power sample is older than the max sample age are expired; as only
+ * outdated samples are visited, this is cheap even if each device of a large fleet delivers its own batch.
+ * @param batch the batch
+ * @param time the sample time in milliseconds for all rows
+ * @return the number of aggregated samples
+ */
+size_t EnergyAggregator::update(const JsonBatch& batch, const int64_t time) {
+    const std::vector<uint32_t>& device_ids = batch.getDeviceIds();
+    const std::vector<PathInterner::PathId>& path_ids = batch.getPathIds();
+    const std::vector<uint8_t>& types = batch.getTypes();
+    size_t num_aggregated = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t row = 0; row < batch.size(); ++row) {
+        if ((path_ids[row] != power_path && path_ids[row] != total_path) ||
+            (types[row] != JsonBatch::VALUE_INTEGER && types[row] != JsonBatch::VALUE_DOUBLE)) {
+            continue;
+        }
+        const double value = (types[row] == JsonBatch::VALUE_INTEGER ? (double)batch.getIntegers()[row] : batch.getDoubles()[row]);
+        const bool aggregated = (path_ids[row] == power_path ? updatePowerLocked(device_ids[row], time, value) : updateTotalLocked(device_ids[row], time, value));
+        num_aggregated += (aggregated ? 1 : 0);
+    }
+    expireDevicesLocked(time);
+    return num_aggregated;
+}
+
+
+/**
+ * Expire devices whose latest power sample is older than the max sample age, e.g. devices that are offline: their power drops out
+ * of the power sums of their groups and is no longer integrated. The next power sample of such a device adds it again, without
+ * integrating the energy over the gap. Energy counters are cumulative and stay in the sums.
+ * Nothing expires if the max sample age is 0. Power samples are queued by time, so the cost grows with the number of outdated
+ * samples rather than with the number of devices.
+ * @param time the current time in milliseconds, in the time base of the samples
+ * @return the number of devices expired by this call
+ */
+size_t EnergyAggregator::expireDevices(const int64_t time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return expireDevicesLocked(time);
+}
+
+
+/**
+ * Get a consistent snapshot of the aggregates of a group. The snapshot is read without taking a lock; if an update of the group is
+ * in progress, the read is retried.
+ * @param group_id the group id
+ * @param snapshot output - the aggregates
+ * @return true, if the group exists
+ */
+bool EnergyAggregator::getSnapshot(const GroupId group_id, GroupSnapshot& snapshot) const {
+    if (group_id >= getNumGroups()) {
+        return false;
+    }
+    const GroupSlot& slot = slots[group_id];
+    for (;;) {
+        const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.time          = slot.time.load(std::memory_order_relaxed);
+        snapshot.power         = slot.power.load(std::memory_order_relaxed);
+        snapshot.average_power = slot.average_power.load(std::memory_order_relaxed);
+        snapshot.energy        = slot.energy.load(std::memory_order_relaxed);
+        snapshot.total         = slot.total.load(std::memory_order_relaxed);
+        snapshot.devices       = slot.devices.load(std::memory_order_relaxed);
+        snapshot.samples       = slot.samples.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+            return true;
+        }
+    }
+}
+
+
+/**
+ * Get the name of a group.
+ * @param group_id the group id
+ * @return the group name, or an empty string if the group does not exist
+ */
+const std::string& EnergyAggregator::getGroupName(const GroupId group_id) const {
+    static const std::string empty;
+    return (group_id < getNumGroups() ? slots[group_id].name : empty);
+}
+
+
+/**
+ * Aggregate a power sample; the mutex must be held by the caller.
+ * The energy of the device since its previous sample is integrated with the trapezoidal rule.
+ */
+bool EnergyAggregator::updatePowerLocked(const uint32_t device_id, const int64_t time, const double power) {
+    std::unordered_map<uint32_t, DeviceState>::iterator it = devices.find(device_id);
+    if (it == devices.end()) {
+        return false;
+    }
+    DeviceState& device = it->second;
+    if (device.has_power && time < device.power_time) {
+        return false;
+    }
+
+    // the energy is not integrated over gaps longer than the max sample age, even if the device has not been expired yet
+    const bool counted = (device.has_power && !device.power_expired);
+    const bool contiguous = (counted && (max_sample_age == 0 || time - device.power_time <= max_sample_age));
+    const double delta = (counted ? power - device.power : power);
+    const double energy = (contiguous ? (double)(time - device.power_time) * (power + device.power) / 7.2e9 : 0.0);   // W * ms => kWh, halved
+    for (size_t i = 0; i < device.groups.size(); ++i) {
+        GroupState& group = groups[device.groups[i]];
+        advanceAverage(group, time);
+        group.power += delta;
+        group.energy += energy;
+        group.devices += (counted ? 0 : 1);
+        group.samples += 1;
+        group.time = (time > group.time ? time : group.time);
+        if (group.samples == 1 || average_period <= 0) {
+            group.average_power = group.power;  // start averaging from the first sample, or follow the sum if averaging is disabled
+        }
+        publish(device.groups[i]);
+    }
+    device.power_time = time;
+    device.power = power;
+    device.has_power = true;
+    device.power_expired = false;
+
+    // queue the sample for expiry; the entries of superseded samples are dropped once they outnumber the devices
+    if (max_sample_age > 0) {
+        expiry_queue.push(Expiry(time, device_id));
+        if (expiry_queue.size() > 2 * devices.size() + 16) {
+            compactExpiryQueue();
+        }
+    }
+    return true;
+}
+
+
+/**
+ * Aggregate an energy counter sample; the mutex must be held by the caller.
+ */
+bool EnergyAggregator::updateTotalLocked(const uint32_t device_id, const int64_t time, const double total) {
+    std::unordered_map<uint32_t, DeviceState>::iterator it = devices.find(device_id);
+    if (it == devices.end()) {
+        return false;
+    }
+    DeviceState& device = it->second;
+    if (device.has_total && time < device.total_time) {
+        return false;
+    }
+    const double delta = (device.has_total ? total - device.total : total);
+    for (size_t i = 0; i < device.groups.size(); ++i) {
+        GroupState& group = groups[device.groups[i]];
+        group.total += delta;
+        group.time = (time > group.time ? time : group.time);
+        publish(device.groups[i]);
+    }
+    device.total_time = time;
+    device.total = total;
+    device.has_total = true;
+    return true;
+}
+
+
+/**
+ * Expire devices with an outdated power sample; the mutex must be held by the caller.
+ * Queue entries are taken oldest first; entries of removed devices and of samples that have been superseded are skipped.
+ */
+size_t EnergyAggregator::expireDevicesLocked(const int64_t time) {
+    if (max_sample_age == 0) {
+        return 0;
+    }
+    size_t num_expired = 0;
+    while (expiry_queue.empty() == false && time - expiry_queue.top().first > max_sample_age) {
+        const Expiry entry = expiry_queue.top();
+        expiry_queue.pop();
+        std::unordered_map<uint32_t, DeviceState>::iterator it = devices.find(entry.second);
+        if (it == devices.end()) {
+            continue;
+        }
+        DeviceState& device = it->second;
+        if (device.has_power == false || device.power_expired || device.power_time != entry.first) {
+            continue;
+        }
+        for (size_t i = 0; i < device.groups.size(); ++i) {
+            GroupState& group = groups[device.groups[i]];
+            advanceAverage(group, group.time);
+            group.power -= device.power;
+            group.devices -= 1;
+            group.average_power = (average_period > 0 ? group.average_power : group.power);
+            publish(device.groups[i]);
+        }
+        device.power_expired = true;
+        ++num_expired;
+    }
+    return num_expired;
+}
+
+
+/**
+ * Rebuild the expiry queue with a single entry for the latest power sample of each device in the power sums;
+ * the mutex must be held by the caller.
+ */
+void EnergyAggregator::compactExpiryQueue(void) {
+    std::vector<Expiry> entries;
+    entries.reserve(devices.size());
+    for (std::unordered_map<uint32_t, DeviceState>::const_iterator it = devices.begin(); it != devices.end(); ++it) {
+        if (it->second.has_power && it->second.power_expired == false) {
+            entries.push_back(Expiry(it->second.power_time, it->first));
+        }
+    }
+    expiry_queue = std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry> >(std::greater<Expiry>(), std::move(entries));
+}
+
+
+/**
+ * Advance the moving average of a group to the given time, assuming the power sum has been constant since the previous update;
+ * the mutex must be held by the caller.
+ */
+void EnergyAggregator::advanceAverage(GroupState& group, const int64_t time) const {
+    if (group.samples == 0 || average_period <= 0) {
+        group.average_power = group.power;
+        group.average_time = time;
+    }
+    else if (time > group.average_time) {
+        const double weight = std::exp(-(double)(time - group.average_time) / (double)average_period);
+        group.average_power = group.power + (group.average_power - group.power) * weight;
+        group.average_time = time;
+    }
+}
+
+
+/**
+ * Publish the aggregates of a group to its slot; the mutex must be held by the caller.
+ * The sequence number is odd while the slot is written, so that readers can detect and retry torn reads.
+ */
+void EnergyAggregator::publish(const GroupId group_id) {
+    const GroupState& group = groups[group_id];
+    GroupSlot& slot = slots[group_id];
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time.store(group.time, std::memory_order_relaxed);
+    slot.power.store(group.power, std::memory_order_relaxed);
+    slot.average_power.store(group.average_power, std::memory_order_relaxed);
+    slot.energy.store(group.energy, std::memory_order_relaxed);
+    slot.total.store(group.total, std::memory_order_relaxed);
+    slot.devices.store(group.devices, std::memory_order_relaxed);
+    slot.samples.store(group.samples, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
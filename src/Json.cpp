@@ -46,6 +46,12 @@ const struct _json_value json_value_none;
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <locale.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_HAVE_SSE2
+#endif
 
 typedef unsigned int json_uchar;
 
@@ -74,11 +80,6 @@ static unsigned char hex_value(json_char c)
     }
 }
 
-static int would_overflow(json_int_t value, json_char b)
-{
-    return ((JSON_INT_MAX - (b - '0')) / 10) < value;
-}
-
 typedef struct
 {
     size_t used_memory;
@@ -92,15 +93,22 @@ typedef struct
     const json_char* ptr;
     unsigned int cur_line, cur_col;
 
+    unsigned int depth;             /* number of values on the chain from the root to the current value */
+    size_t num_values;              /* number of values created so far */
+    const char* limit_error;        /* set if an allocation was refused because of a limit */
+    json_value* validate_pool;      /* json_validate_only: one value per nesting level, nothing is allocated */
+
 } json_state;
 
 static void* default_alloc(size_t size, int zero, void* user_data)
 {
+    (void)user_data;
     return zero ? calloc(1, size) : malloc(size);
 }
 
 static void default_free(void* ptr, void* user_data)
 {
+    (void)user_data;
     free(ptr);
 }
 
@@ -118,6 +126,26 @@ static void* json_alloc(json_state* state, size_t size, int zero)
     return state->settings.mem_alloc(size, zero, state->settings.user_data);
 }
 
+/* Check the depth and element limits before a value is created */
+static int json_check_limits(json_state* state, unsigned int depth, json_type type)
+{
+    if (state->settings.max_depth && (type == json_object || type == json_array)
+        && depth >= state->settings.max_depth)
+    {
+        state->limit_error = "Too deeply nested";
+        return 0;
+    }
+
+    if (state->settings.max_elements && state->num_values >= state->settings.max_elements)
+    {
+        state->limit_error = "Too many elements";
+        return 0;
+    }
+
+    ++state->num_values;
+    return 1;
+}
+
 static int new_value(json_state* state,
     json_value** top, json_value** root, json_value** alloc,
     json_type type)
@@ -125,6 +153,27 @@ static int new_value(json_state* state,
     json_value* value;
     int values_size;
 
+    if (state->first_pass && !json_check_limits(state, state->depth, type))
+        return 0;
+
+    ++state->depth;
+
+    if (state->validate_pool)
+    {
+        /* the values on the chain are containers, so the slot of this level is free */
+        value = &state->validate_pool[state->depth - 1];
+        *value = json_value();
+
+        if (!*root)
+            *root = value;
+
+        value->type = type;
+        value->parent = *top;
+        *top = value;
+
+        return 1;
+    }
+
     if (!state->first_pass)
     {
         value = *top = *alloc;
@@ -210,6 +259,684 @@ static int new_value(json_state* state,
     return 1;
 }
 
+/* Number conversion
+ *
+ * Numbers are scanned as a whole token. Integers that fit into json_int_t are
+ * accumulated directly. Everything else is reduced to a decimal mantissa of
+ * at most 19 significant digits and a decimal exponent, which is converted to
+ * the correctly rounded double by Clinger's exact fast path or, failing that,
+ * by the Eisel-Lemire algorithm. The rare inputs neither of them can decide
+ * fall back to strtod().
+ */
+
+typedef enum
+{
+    json_number_ok,
+    json_number_e_digit,
+    json_number_e_leading_zero,
+    json_number_e_fraction,
+    json_number_e_exponent
+
+} json_number_status;
+
+typedef struct
+{
+    const json_char* end;       /* first character after the number */
+    uint64_t mantissa;          /* up to 19 significant decimal digits */
+    int64_t exponent;           /* decimal exponent applied to mantissa */
+    int negative;
+    int is_integer;             /* neither fraction nor exponent part */
+    int truncated;              /* non-zero digits beyond the 19th were dropped */
+
+} json_number;
+
+#define json_is_digit(c)  ((unsigned char)((c) - '0') < 10)
+
+static json_number_status json_scan_number(const json_char* ptr, const json_char* end, json_number* num)
+{
+    const json_char* int_start, * int_end, * frac_start, * frac_end;
+    int64_t exp_value = 0;
+    int exp_negative = 0;
+    int digits = 0;
+    const json_char* p;
+
+    num->mantissa = 0;
+    num->exponent = 0;
+    num->negative = 0;
+    num->is_integer = 1;
+    num->truncated = 0;
+
+    if (ptr < end && *ptr == '-')
+    {
+        num->negative = 1;
+        ++ptr;
+    }
+
+    if (ptr == end || !json_is_digit(*ptr))
+        return json_number_e_digit;
+
+    int_start = ptr;
+
+    if (*ptr == '0')
+    {
+        if (++ptr < end && json_is_digit(*ptr))
+        {
+            num->end = ptr;
+            return json_number_e_leading_zero;
+        }
+    }
+    else
+    {
+        while (ptr < end && json_is_digit(*ptr))
+            ++ptr;
+    }
+
+    int_end = frac_start = frac_end = ptr;
+
+    if (ptr < end && *ptr == '.')
+    {
+        num->is_integer = 0;
+        frac_start = ++ptr;
+
+        while (ptr < end && json_is_digit(*ptr))
+            ++ptr;
+
+        frac_end = ptr;
+
+        if (frac_start == frac_end)
+            return json_number_e_fraction;
+    }
+
+    if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        num->is_integer = 0;
+
+        if (++ptr < end && (*ptr == '+' || *ptr == '-'))
+            exp_negative = (*ptr++ == '-');
+
+        if (ptr == end || !json_is_digit(*ptr))
+            return json_number_e_exponent;
+
+        while (ptr < end && json_is_digit(*ptr))
+        {
+            if (exp_value < 0x10000000)
+                exp_value = (exp_value * 10) + (*ptr - '0');
+            ++ptr;
+        }
+    }
+
+    num->end = ptr;
+    num->exponent = (exp_negative ? -exp_value : exp_value);
+
+    /* Collect the significant digits; leading zeros do not count towards the
+     * 19 digits, dropped integer digits scale the exponent up and consumed
+     * fraction digits scale it down.
+     */
+    for (p = int_start; p < int_end; ++p)
+    {
+        if (digits < 19)
+        {
+            num->mantissa = (num->mantissa * 10) + (*p - '0');
+            if (num->mantissa)
+                ++digits;
+        }
+        else
+        {
+            num->truncated |= (*p != '0');
+            ++num->exponent;
+        }
+    }
+
+    for (p = frac_start; p < frac_end; ++p)
+    {
+        if (digits < 19)
+        {
+            num->mantissa = (num->mantissa * 10) + (*p - '0');
+            if (num->mantissa)
+                ++digits;
+            --num->exponent;
+        }
+        else
+            num->truncated |= (*p != '0');
+    }
+
+    return json_number_ok;
+}
+
+static uint64_t json_mul128(uint64_t a, uint64_t b, uint64_t* hi)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    *hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    return (cross << 32) | (uint32_t)lo_lo;
+#endif
+}
+
+static int json_clz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    if (!(x >> 32)) { n += 32; x <<= 32; }
+    if (!(x >> 48)) { n += 16; x <<= 16; }
+    if (!(x >> 56)) { n += 8;  x <<= 8;  }
+    if (!(x >> 60)) { n += 4;  x <<= 4;  }
+    if (!(x >> 62)) { n += 2;  x <<= 2;  }
+    if (!(x >> 63)) { n += 1; }
+    return n;
+#endif
+}
+
+static double json_to_double(uint64_t mantissa, int64_t exponent, int negative)
+{
+    uint64_t bits = mantissa | ((uint64_t)exponent << 52) | ((uint64_t)negative << 63);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+/* Truncated 128 bit approximations of 5^q for q in [-342, 308], normalized so
+ * that the most significant bit is set.
+ */
+#define JSON_POW5_MIN  -342
+#define JSON_POW5_MAX  308
+
+static const uint64_t json_pow5_128[][2] =
+{
+    { 0xeef453d6923bd65a, 0x113faa2906a13b3f }, { 0x9558b4661b6565f8, 0x4ac7ca59a424c507 },
+    { 0xbaaee17fa23ebf76, 0x5d79bcf00d2df649 }, { 0xe95a99df8ace6f53, 0xf4d82c2c107973dc },
+    { 0x91d8a02bb6c10594, 0x79071b9b8a4be869 }, { 0xb64ec836a47146f9, 0x9748e2826cdee284 },
+    { 0xe3e27a444d8d98b7, 0xfd1b1b2308169b25 }, { 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7 },
+    { 0xb208ef855c969f4f, 0xbdbd2d335e51a935 }, { 0xde8b2b66b3bc4723, 0xad2c788035e61382 },
+    { 0x8b16fb203055ac76, 0x4c3bcb5021afcc31 }, { 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d },
+    { 0xd953e8624b85dd78, 0xd71d6dad34a2af0d }, { 0x87d4713d6f33aa6b, 0x8672648c40e5ad68 },
+    { 0xa9c98d8ccb009506, 0x680efdaf511f18c2 }, { 0xd43bf0effdc0ba48, 0x0212bd1b2566def2 },
+    { 0x84a57695fe98746d, 0x014bb630f7604b57 }, { 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d },
+    { 0xcf42894a5dce35ea, 0x52064cac828675b9 }, { 0x818995ce7aa0e1b2, 0x7343efebd1940993 },
+    { 0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8 }, { 0xca66fa129f9b60a6, 0xd41a26e077774ef6 },
+    { 0xfd00b897478238d0, 0x8920b098955522b4 }, { 0x9e20735e8cb16382, 0x55b46e5f5d5535b0 },
+    { 0xc5a890362fddbc62, 0xeb2189f734aa831d }, { 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4 },
+    { 0x9a6bb0aa55653b2d, 0x47b233c92125366e }, { 0xc1069cd4eabe89f8, 0x999ec0bb696e840a },
+    { 0xf148440a256e2c76, 0xc00670ea43ca250d }, { 0x96cd2a865764dbca, 0x380406926a5e5728 },
+    { 0xbc807527ed3e12bc, 0xc605083704f5ecf2 }, { 0xeba09271e88d976b, 0xf7864a44c633682e },
+    { 0x93445b8731587ea3, 0x7ab3ee6afbe0211d }, { 0xb8157268fdae9e4c, 0x5960ea05bad82964 },
+    { 0xe61acf033d1a45df, 0x6fb92487298e33bd }, { 0x8fd0c16206306bab, 0xa5d3b6d479f8e056 },
+    { 0xb3c4f1ba87bc8696, 0x8f48a4899877186c }, { 0xe0b62e2929aba83c, 0x331acdabfe94de87 },
+    { 0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14 }, { 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9 },
+    { 0xdb71e91432b1a24a, 0xc9e82cd9f69d6150 }, { 0x892731ac9faf056e, 0xbe311c083a225cd2 },
+    { 0xab70fe17c79ac6ca, 0x6dbd630a48aaf406 }, { 0xd64d3d9db981787d, 0x092cbbccdad5b108 },
+    { 0x85f0468293f0eb4e, 0x25bbf56008c58ea5 }, { 0xa76c582338ed2621, 0xaf2af2b80af6f24e },
+    { 0xd1476e2c07286faa, 0x1af5af660db4aee1 }, { 0x82cca4db847945ca, 0x50d98d9fc890ed4d },
+    { 0xa37fce126597973c, 0xe50ff107bab528a0 }, { 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8 },
+    { 0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a }, { 0x9faacf3df73609b1, 0x77b191618c54e9ac },
+    { 0xc795830d75038c1d, 0xd59df5b9ef6a2417 }, { 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d },
+    { 0x9becce62836ac577, 0x4ee367f9430aec32 }, { 0xc2e801fb244576d5, 0x229c41f793cda73f },
+    { 0xf3a20279ed56d48a, 0x6b43527578c1110f }, { 0x9845418c345644d6, 0x830a13896b78aaa9 },
+    { 0xbe5691ef416bd60c, 0x23cc986bc656d553 }, { 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8 },
+    { 0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9 }, { 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53 },
+    { 0xe858ad248f5c22c9, 0xd1b3400f8f9cff68 }, { 0x91376c36d99995be, 0x23100809b9c21fa1 },
+    { 0xb58547448ffffb2d, 0xabd40a0c2832a78a }, { 0xe2e69915b3fff9f9, 0x16c90c8f323f516c },
+    { 0x8dd01fad907ffc3b, 0xae3da7d97f6792e3 }, { 0xb1442798f49ffb4a, 0x99cd11cfdf41779c },
+    { 0xdd95317f31c7fa1d, 0x40405643d711d583 }, { 0x8a7d3eef7f1cfc52, 0x482835ea666b2572 },
+    { 0xad1c8eab5ee43b66, 0xda3243650005eecf }, { 0xd863b256369d4a40, 0x90bed43e40076a82 },
+    { 0x873e4f75e2224e68, 0x5a7744a6e804a291 }, { 0xa90de3535aaae202, 0x711515d0a205cb36 },
+    { 0xd3515c2831559a83, 0x0d5a5b44ca873e03 }, { 0x8412d9991ed58091, 0xe858790afe9486c2 },
+    { 0xa5178fff668ae0b6, 0x626e974dbe39a872 }, { 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f },
+    { 0x80fa687f881c7f8e, 0x7ce66634bc9d0b99 }, { 0xa139029f6a239f72, 0x1c1fffc1ebc44e80 },
+    { 0xc987434744ac874e, 0xa327ffb266b56220 }, { 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8 },
+    { 0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9 }, { 0xc4ce17b399107c22, 0xcb550fb4384d21d3 },
+    { 0xf6019da07f549b2b, 0x7e2a53a146606a48 }, { 0x99c102844f94e0fb, 0x2eda7444cbfc426d },
+    { 0xc0314325637a1939, 0xfa911155fefb5308 }, { 0xf03d93eebc589f88, 0x793555ab7eba27ca },
+    { 0x96267c7535b763b5, 0x4bc1558b2f3458de }, { 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16 },
+    { 0xea9c227723ee8bcb, 0x465e15a979c1cadc }, { 0x92a1958a7675175f, 0x0bfacd89ec191ec9 },
+    { 0xb749faed14125d36, 0xcef980ec671f667b }, { 0xe51c79a85916f484, 0x82b7e12780e7401a },
+    { 0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810 }, { 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15 },
+    { 0xdfbdcece67006ac9, 0x67a791e093e1d49a }, { 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0 },
+    { 0xaecc49914078536d, 0x58fae9f773886e18 }, { 0xda7f5bf590966848, 0xaf39a475506a899e },
+    { 0x888f99797a5e012d, 0x6d8406c952429603 }, { 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83 },
+    { 0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64 }, { 0x855c3be0a17fcd26, 0x5cf2eea09a55067f },
+    { 0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e }, { 0xd0601d8efc57b08b, 0xf13b94daf124da26 },
+    { 0x823c12795db6ce57, 0x76c53d08d6b70858 }, { 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e },
+    { 0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09 }, { 0xfe5d54150b090b02, 0xd3f93b35435d7c4c },
+    { 0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf }, { 0xc6b8e9b0709f109a, 0x359ab6419ca1091b },
+    { 0xf867241c8cc6d4c0, 0xc30163d203c94b62 }, { 0x9b407691d7fc44f8, 0x79e0de63425dcf1d },
+    { 0xc21094364dfb5636, 0x985915fc12f542e4 }, { 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d },
+    { 0x979cf3ca6cec5b5a, 0xa705992ceecf9c42 }, { 0xbd8430bd08277231, 0x50c6ff782a838353 },
+    { 0xece53cec4a314ebd, 0xa4f8bf5635246428 }, { 0x940f4613ae5ed136, 0x871b7795e136be99 },
+    { 0xb913179899f68584, 0x28e2557b59846e3f }, { 0xe757dd7ec07426e5, 0x331aeada2fe589cf },
+    { 0x9096ea6f3848984f, 0x3ff0d2c85def7621 }, { 0xb4bca50b065abe63, 0x0fed077a756b53a9 },
+    { 0xe1ebce4dc7f16dfb, 0xd3e8495912c62894 }, { 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c },
+    { 0xb080392cc4349dec, 0xbd8d794d96aacfb3 }, { 0xdca04777f541c567, 0xecf0d7a0fc5583a0 },
+    { 0x89e42caaf9491b60, 0xf41686c49db57244 }, { 0xac5d37d5b79b6239, 0x311c2875c522ced5 },
+    { 0xd77485cb25823ac7, 0x7d633293366b828b }, { 0x86a8d39ef77164bc, 0xae5dff9c02033197 },
+    { 0xa8530886b54dbdeb, 0xd9f57f830283fdfc }, { 0xd267caa862a12d66, 0xd072df63c324fd7b },
+    { 0x8380dea93da4bc60, 0x4247cb9e59f71e6d }, { 0xa46116538d0deb78, 0x52d9be85f074e608 },
+    { 0xcd795be870516656, 0x67902e276c921f8b }, { 0x806bd9714632dff6, 0x00ba1cd8a3db53b6 },
+    { 0xa086cfcd97bf97f3, 0x80e8a40eccd228a4 }, { 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd },
+    { 0xfad2a4b13d1b5d6c, 0x796b805720085f81 }, { 0x9cc3a6eec6311a63, 0xcbe3303674053bb0 },
+    { 0xc3f490aa77bd60fc, 0xbedbfc4411068a9c }, { 0xf4f1b4d515acb93b, 0xee92fb5515482d44 },
+    { 0x991711052d8bf3c5, 0x751bdd152d4d1c4a }, { 0xbf5cd54678eef0b6, 0xd262d45a78a0635d },
+    { 0xef340a98172aace4, 0x86fb897116c87c34 }, { 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0 },
+    { 0xbae0a846d2195712, 0x8974836059cca109 }, { 0xe998d258869facd7, 0x2bd1a438703fc94b },
+    { 0x91ff83775423cc06, 0x7b6306a34627ddcf }, { 0xb67f6455292cbf08, 0x1a3bc84c17b1d542 },
+    { 0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93 }, { 0x8e938662882af53e, 0x547eb47b7282ee9c },
+    { 0xb23867fb2a35b28d, 0xe99e619a4f23aa43 }, { 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4 },
+    { 0x8b3c113c38f9f37e, 0xde83bc408dd3dd04 }, { 0xae0b158b4738705e, 0x9624ab50b148d445 },
+    { 0xd98ddaee19068c76, 0x3badd624dd9b0957 }, { 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6 },
+    { 0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c }, { 0xd47487cc8470652b, 0x7647c3200069671f },
+    { 0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073 }, { 0xa5fb0a17c777cf09, 0xf468107100525890 },
+    { 0xcf79cc9db955c2cc, 0x7182148d4066eeb4 }, { 0x81ac1fe293d599bf, 0xc6f14cd848405530 },
+    { 0xa21727db38cb002f, 0xb8ada00e5a506a7c }, { 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c },
+    { 0xfd442e4688bd304a, 0x908f4a166d1da663 }, { 0x9e4a9cec15763e2e, 0x9a598e4e043287fe },
+    { 0xc5dd44271ad3cdba, 0x40eff1e1853f29fd }, { 0xf7549530e188c128, 0xd12bee59e68ef47c },
+    { 0x9a94dd3e8cf578b9, 0x82bb74f8301958ce }, { 0xc13a148e3032d6e7, 0xe36a52363c1faf01 },
+    { 0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1 }, { 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9 },
+    { 0xbcb2b812db11a5de, 0x7415d448f6b6f0e7 }, { 0xebdf661791d60f56, 0x111b495b3464ad21 },
+    { 0x936b9fcebb25c995, 0xcab10dd900beec34 }, { 0xb84687c269ef3bfb, 0x3d5d514f40eea742 },
+    { 0xe65829b3046b0afa, 0x0cb4a5a3112a5112 }, { 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab },
+    { 0xb3f4e093db73a093, 0x59ed216765690f56 }, { 0xe0f218b8d25088b8, 0x306869c13ec3532c },
+    { 0x8c974f7383725573, 0x1e414218c73a13fb }, { 0xafbd2350644eeacf, 0xe5d1929ef90898fa },
+    { 0xdbac6c247d62a583, 0xdf45f746b74abf39 }, { 0x894bc396ce5da772, 0x6b8bba8c328eb783 },
+    { 0xab9eb47c81f5114f, 0x066ea92f3f326564 }, { 0xd686619ba27255a2, 0xc80a537b0efefebd },
+    { 0x8613fd0145877585, 0xbd06742ce95f5f36 }, { 0xa798fc4196e952e7, 0x2c48113823b73704 },
+    { 0xd17f3b51fca3a7a0, 0xf75a15862ca504c5 }, { 0x82ef85133de648c4, 0x9a984d73dbe722fb },
+    { 0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba }, { 0xcc963fee10b7d1b3, 0x318df905079926a8 },
+    { 0xffbbcfe994e5c61f, 0xfdf17746497f7052 }, { 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633 },
+    { 0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0 }, { 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0 },
+    { 0x9c1661a651213e2d, 0x06bea10ca65c084e }, { 0xc31bfa0fe5698db8, 0x486e494fcff30a62 },
+    { 0xf3e2f893dec3f126, 0x5a89dba3c3efccfa }, { 0x986ddb5c6b3a76b7, 0xf89629465a75e01c },
+    { 0xbe89523386091465, 0xf6bbb397f1135823 }, { 0xee2ba6c0678b597f, 0x746aa07ded582e2c },
+    { 0x94db483840b717ef, 0xa8c2a44eb4571cdc }, { 0xba121a4650e4ddeb, 0x92f34d62616ce413 },
+    { 0xe896a0d7e51e1566, 0x77b020baf9c81d17 }, { 0x915e2486ef32cd60, 0x0ace1474dc1d122e },
+    { 0xb5b5ada8aaff80b8, 0x0d819992132456ba }, { 0xe3231912d5bf60e6, 0x10e1fff697ed6c69 },
+    { 0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1 }, { 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2 },
+    { 0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde }, { 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b },
+    { 0xad4ab7112eb3929d, 0x86c16c98d2c953c6 }, { 0xd89d64d57a607744, 0xe871c7bf077ba8b7 },
+    { 0x87625f056c7c4a8b, 0x11471cd764ad4972 }, { 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf },
+    { 0xd389b47879823479, 0x4aff1d108d4ec2c3 }, { 0x843610cb4bf160cb, 0xcedf722a585139ba },
+    { 0xa54394fe1eedb8fe, 0xc2974eb4ee658828 }, { 0xce947a3da6a9273e, 0x733d226229feea32 },
+    { 0x811ccc668829b887, 0x0806357d5a3f525f }, { 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7 },
+    { 0xc9bcff6034c13052, 0xfc89b393dd02f0b5 }, { 0xfc2c3f3841f17c67, 0xbbac2078d443ace2 },
+    { 0x9d9ba7832936edc0, 0xd54b944b84aa4c0d }, { 0xc5029163f384a931, 0x0a9e795e65d4df11 },
+    { 0xf64335bcf065d37d, 0x4d4617b5ff4a16d5 }, { 0x99ea0196163fa42e, 0x504bced1bf8e4e45 },
+    { 0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6 }, { 0xf07da27a82c37088, 0x5d767327bb4e5a4c },
+    { 0x964e858c91ba2655, 0x3a6a07f8d510f86f }, { 0xbbe226efb628afea, 0x890489f70a55368b },
+    { 0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e }, { 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d },
+    { 0xb77ada0617e3bbcb, 0x09ce6ebb40173744 }, { 0xe55990879ddcaabd, 0xcc420a6a101d0515 },
+    { 0x8f57fa54c2a9eab6, 0x9fa946824a12232d }, { 0xb32df8e9f3546564, 0x47939822dc96abf9 },
+    { 0xdff9772470297ebd, 0x59787e2b93bc56f7 }, { 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a },
+    { 0xaefae51477a06b03, 0xede622920b6b23f1 }, { 0xdab99e59958885c4, 0xe95fab368e45eced },
+    { 0x88b402f7fd75539b, 0x11dbcb0218ebb414 }, { 0xaae103b5fcd2a881, 0xd652bdc29f26a119 },
+    { 0xd59944a37c0752a2, 0x4be76d3346f0495f }, { 0x857fcae62d8493a5, 0x6f70a4400c562ddb },
+    { 0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952 }, { 0xd097ad07a71f26b2, 0x7e2000a41346a7a7 },
+    { 0x825ecc24c873782f, 0x8ed400668c0c28c8 }, { 0xa2f67f2dfa90563b, 0x728900802f0f32fa },
+    { 0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9 }, { 0xfea126b7d78186bc, 0xe2f610c84987bfa8 },
+    { 0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9 }, { 0xc6ede63fa05d3143, 0x91503d1c79720dbb },
+    { 0xf8a95fcf88747d94, 0x75a44c6397ce912a }, { 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba },
+    { 0xc24452da229b021b, 0xfbe85badce996168 }, { 0xf2d56790ab41c2a2, 0xfae27299423fb9c3 },
+    { 0x97c560ba6b0919a5, 0xdccd879fc967d41a }, { 0xbdb6b8e905cb600f, 0x5400e987bbc1c920 },
+    { 0xed246723473e3813, 0x290123e9aab23b68 }, { 0x9436c0760c86e30b, 0xf9a0b6720aaf6521 },
+    { 0xb94470938fa89bce, 0xf808e40e8d5b3e69 }, { 0xe7958cb87392c2c2, 0xb60b1d1230b20e04 },
+    { 0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2 }, { 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3 },
+    { 0xe2280b6c20dd5232, 0x25c6da63c38de1b0 }, { 0x8d590723948a535f, 0x579c487e5a38ad0e },
+    { 0xb0af48ec79ace837, 0x2d835a9df0c6d851 }, { 0xdcdb1b2798182244, 0xf8e431456cf88e65 },
+    { 0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff }, { 0xac8b2d36eed2dac5, 0xe272467e3d222f3f },
+    { 0xd7adf884aa879177, 0x5b0ed81dcc6abb0f }, { 0x86ccbb52ea94baea, 0x98e947129fc2b4e9 },
+    { 0xa87fea27a539e9a5, 0x3f2398d747b36224 }, { 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad },
+    { 0x83a3eeeef9153e89, 0x1953cf68300424ac }, { 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7 },
+    { 0xcdb02555653131b6, 0x3792f412cb06794d }, { 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0 },
+    { 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4 }, { 0xc8de047564d20a8b, 0xf245825a5a445275 },
+    { 0xfb158592be068d2e, 0xeed6e2f0f0d56712 }, { 0x9ced737bb6c4183d, 0x55464dd69685606b },
+    { 0xc428d05aa4751e4c, 0xaa97e14c3c26b886 }, { 0xf53304714d9265df, 0xd53dd99f4b3066a8 },
+    { 0x993fe2c6d07b7fab, 0xe546a8038efe4029 }, { 0xbf8fdb78849a5f96, 0xde98520472bdd033 },
+    { 0xef73d256a5c0f77c, 0x963e66858f6d4440 }, { 0x95a8637627989aad, 0xdde7001379a44aa8 },
+    { 0xbb127c53b17ec159, 0x5560c018580d5d52 }, { 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6 },
+    { 0x9226712162ab070d, 0xcab3961304ca70e8 }, { 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22 },
+    { 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a }, { 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242 },
+    { 0xb267ed1940f1c61c, 0x55f038b237591ed3 }, { 0xdf01e85f912e37a3, 0x6b6c46dec52f6688 },
+    { 0x8b61313bbabce2c6, 0x2323ac4b3b3da015 }, { 0xae397d8aa96c1b77, 0xabec975e0a0d081a },
+    { 0xd9c7dced53c72255, 0x96e7bd358c904a21 }, { 0x881cea14545c7575, 0x7e50d64177da2e54 },
+    { 0xaa242499697392d2, 0xdde50bd1d5d0b9e9 }, { 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864 },
+    { 0x84ec3c97da624ab4, 0xbd5af13bef0b113e }, { 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e },
+    { 0xcfb11ead453994ba, 0x67de18eda5814af2 }, { 0x81ceb32c4b43fcf4, 0x80eacf948770ced7 },
+    { 0xa2425ff75e14fc31, 0xa1258379a94d028d }, { 0xcad2f7f5359a3b3e, 0x096ee45813a04330 },
+    { 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc }, { 0x9e74d1b791e07e48, 0x775ea264cf55347e },
+    { 0xc612062576589dda, 0x95364afe032a819e }, { 0xf79687aed3eec551, 0x3a83ddbd83f52205 },
+    { 0x9abe14cd44753b52, 0xc4926a9672793543 }, { 0xc16d9a0095928a27, 0x75b7053c0f178294 },
+    { 0xf1c90080baf72cb1, 0x5324c68b12dd6339 }, { 0x971da05074da7bee, 0xd3f6fc16ebca5e04 },
+    { 0xbce5086492111aea, 0x88f4bb1ca6bcf585 }, { 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6 },
+    { 0x9392ee8e921d5d07, 0x3aff322e62439fd0 }, { 0xb877aa3236a4b449, 0x09befeb9fad487c3 },
+    { 0xe69594bec44de15b, 0x4c2ebe687989a9b4 }, { 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11 },
+    { 0xb424dc35095cd80f, 0x538484c19ef38c95 }, { 0xe12e13424bb40e13, 0x2865a5f206b06fba },
+    { 0x8cbccc096f5088cb, 0xf93f87b7442e45d4 }, { 0xafebff0bcb24aafe, 0xf78f69a51539d749 },
+    { 0xdbe6fecebdedd5be, 0xb573440e5a884d1c }, { 0x89705f4136b4a597, 0x31680a88f8953031 },
+    { 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e }, { 0xd6bf94d5e57a42bc, 0x3d32907604691b4d },
+    { 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110 }, { 0xa7c5ac471b478423, 0x0fcf80dc33721d54 },
+    { 0xd1b71758e219652b, 0xd3c36113404ea4a9 }, { 0x83126e978d4fdf3b, 0x645a1cac083126ea },
+    { 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4 }, { 0xcccccccccccccccc, 0xcccccccccccccccd },
+    { 0x8000000000000000, 0x0000000000000000 }, { 0xa000000000000000, 0x0000000000000000 },
+    { 0xc800000000000000, 0x0000000000000000 }, { 0xfa00000000000000, 0x0000000000000000 },
+    { 0x9c40000000000000, 0x0000000000000000 }, { 0xc350000000000000, 0x0000000000000000 },
+    { 0xf424000000000000, 0x0000000000000000 }, { 0x9896800000000000, 0x0000000000000000 },
+    { 0xbebc200000000000, 0x0000000000000000 }, { 0xee6b280000000000, 0x0000000000000000 },
+    { 0x9502f90000000000, 0x0000000000000000 }, { 0xba43b74000000000, 0x0000000000000000 },
+    { 0xe8d4a51000000000, 0x0000000000000000 }, { 0x9184e72a00000000, 0x0000000000000000 },
+    { 0xb5e620f480000000, 0x0000000000000000 }, { 0xe35fa931a0000000, 0x0000000000000000 },
+    { 0x8e1bc9bf04000000, 0x0000000000000000 }, { 0xb1a2bc2ec5000000, 0x0000000000000000 },
+    { 0xde0b6b3a76400000, 0x0000000000000000 }, { 0x8ac7230489e80000, 0x0000000000000000 },
+    { 0xad78ebc5ac620000, 0x0000000000000000 }, { 0xd8d726b7177a8000, 0x0000000000000000 },
+    { 0x878678326eac9000, 0x0000000000000000 }, { 0xa968163f0a57b400, 0x0000000000000000 },
+    { 0xd3c21bcecceda100, 0x0000000000000000 }, { 0x84595161401484a0, 0x0000000000000000 },
+    { 0xa56fa5b99019a5c8, 0x0000000000000000 }, { 0xcecb8f27f4200f3a, 0x0000000000000000 },
+    { 0x813f3978f8940984, 0x4000000000000000 }, { 0xa18f07d736b90be5, 0x5000000000000000 },
+    { 0xc9f2c9cd04674ede, 0xa400000000000000 }, { 0xfc6f7c4045812296, 0x4d00000000000000 },
+    { 0x9dc5ada82b70b59d, 0xf020000000000000 }, { 0xc5371912364ce305, 0x6c28000000000000 },
+    { 0xf684df56c3e01bc6, 0xc732000000000000 }, { 0x9a130b963a6c115c, 0x3c7f400000000000 },
+    { 0xc097ce7bc90715b3, 0x4b9f100000000000 }, { 0xf0bdc21abb48db20, 0x1e86d40000000000 },
+    { 0x96769950b50d88f4, 0x1314448000000000 }, { 0xbc143fa4e250eb31, 0x17d955a000000000 },
+    { 0xeb194f8e1ae525fd, 0x5dcfab0800000000 }, { 0x92efd1b8d0cf37be, 0x5aa1cae500000000 },
+    { 0xb7abc627050305ad, 0xf14a3d9e40000000 }, { 0xe596b7b0c643c719, 0x6d9ccd05d0000000 },
+    { 0x8f7e32ce7bea5c6f, 0xe4820023a2000000 }, { 0xb35dbf821ae4f38b, 0xdda2802c8a800000 },
+    { 0xe0352f62a19e306e, 0xd50b2037ad200000 }, { 0x8c213d9da502de45, 0x4526f422cc340000 },
+    { 0xaf298d050e4395d6, 0x9670b12b7f410000 }, { 0xdaf3f04651d47b4c, 0x3c0cdd765f114000 },
+    { 0x88d8762bf324cd0f, 0xa5880a69fb6ac800 }, { 0xab0e93b6efee0053, 0x8eea0d047a457a00 },
+    { 0xd5d238a4abe98068, 0x72a4904598d6d880 }, { 0x85a36366eb71f041, 0x47a6da2b7f864750 },
+    { 0xa70c3c40a64e6c51, 0x999090b65f67d924 }, { 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d },
+    { 0x82818f1281ed449f, 0xbff8f10e7a8921a4 }, { 0xa321f2d7226895c7, 0xaff72d52192b6a0d },
+    { 0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490 }, { 0xfee50b7025c36a08, 0x02f236d04753d5b4 },
+    { 0x9f4f2726179a2245, 0x01d762422c946590 }, { 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5 },
+    { 0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2 }, { 0x9b934c3b330c8577, 0x63cc55f49f88eb2f },
+    { 0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb }, { 0xf316271c7fc3908a, 0x8bef464e3945ef7a },
+    { 0x97edd871cfda3a56, 0x97758bf0e3cbb5ac }, { 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317 },
+    { 0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd }, { 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a },
+    { 0xb975d6b6ee39e436, 0xb3e2fd538e122b44 }, { 0xe7d34c64a9c85d44, 0x60dbbca87196b616 },
+    { 0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd }, { 0xb51d13aea4a488dd, 0x6babab6398bdbe41 },
+    { 0xe264589a4dcdab14, 0xc696963c7eed2dd1 }, { 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2 },
+    { 0xb0de65388cc8ada8, 0x3b25a55f43294bcb }, { 0xdd15fe86affad912, 0x49ef0eb713f39ebe },
+    { 0x8a2dbf142dfcc7ab, 0x6e3569326c784337 }, { 0xacb92ed9397bf996, 0x49c2c37f07965404 },
+    { 0xd7e77a8f87daf7fb, 0xdc33745ec97be906 }, { 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3 },
+    { 0xa8acd7c0222311bc, 0xc40832ea0d68ce0c }, { 0xd2d80db02aabd62b, 0xf50a3fa490c30190 },
+    { 0x83c7088e1aab65db, 0x792667c6da79e0fa }, { 0xa4b8cab1a1563f52, 0x577001b891185938 },
+    { 0xcde6fd5e09abcf26, 0xed4c0226b55e6f86 }, { 0x80b05e5ac60b6178, 0x544f8158315b05b4 },
+    { 0xa0dc75f1778e39d6, 0x696361ae3db1c721 }, { 0xc913936dd571c84c, 0x03bc3a19cd1e38e9 },
+    { 0xfb5878494ace3a5f, 0x04ab48a04065c723 }, { 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76 },
+    { 0xc45d1df942711d9a, 0x3ba5d0bd324f8394 }, { 0xf5746577930d6500, 0xca8f44ec7ee36479 },
+    { 0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb }, { 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e },
+    { 0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e }, { 0x95d04aee3b80ece5, 0xbba1f1d158724a12 },
+    { 0xbb445da9ca61281f, 0x2a8a6e45ae8edc97 }, { 0xea1575143cf97226, 0xf52d09d71a3293bd },
+    { 0x924d692ca61be758, 0x593c2626705f9c56 }, { 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c },
+    { 0xe498f455c38b997a, 0x0b6dfb9c0f956447 }, { 0x8edf98b59a373fec, 0x4724bd4189bd5eac },
+    { 0xb2977ee300c50fe7, 0x58edec91ec2cb657 }, { 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed },
+    { 0x8b865b215899f46c, 0xbd79e0d20082ee74 }, { 0xae67f1e9aec07187, 0xecd8590680a3aa11 },
+    { 0xda01ee641a708de9, 0xe80e6f4820cc9495 }, { 0x884134fe908658b2, 0x3109058d147fdcdd },
+    { 0xaa51823e34a7eede, 0xbd4b46f0599fd415 }, { 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a },
+    { 0x850fadc09923329e, 0x03e2cf6bc604ddb0 }, { 0xa6539930bf6bff45, 0x84db8346b786151c },
+    { 0xcfe87f7cef46ff16, 0xe612641865679a63 }, { 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e },
+    { 0xa26da3999aef7749, 0xe3be5e330f38f09d }, { 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5 },
+    { 0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6 }, { 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa },
+    { 0xc646d63501a1511d, 0xb281e1fd541501b8 }, { 0xf7d88bc24209a565, 0x1f225a7ca91a4226 },
+    { 0x9ae757596946075f, 0x3375788de9b06958 }, { 0xc1a12d2fc3978937, 0x0052d6b1641c83ae },
+    { 0xf209787bb47d6b84, 0xc0678c5dbd23a49a }, { 0x9745eb4d50ce6332, 0xf840b7ba963646e0 },
+    { 0xbd176620a501fbff, 0xb650e5a93bc3d898 }, { 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe },
+    { 0x93ba47c980e98cdf, 0xc66f336c36b10137 }, { 0xb8a8d9bbe123f017, 0xb80b0047445d4184 },
+    { 0xe6d3102ad96cec1d, 0xa60dc059157491e5 }, { 0x9043ea1ac7e41392, 0x87c89837ad68db2f },
+    { 0xb454e4a179dd1877, 0x29babe4598c311fb }, { 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a },
+    { 0x8ce2529e2734bb1d, 0x1899e4a65f58660c }, { 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f },
+    { 0xdc21a1171d42645d, 0x76707543f4fa1f73 }, { 0x899504ae72497eba, 0x6a06494a791c53a8 },
+    { 0xabfa45da0edbde69, 0x0487db9d17636892 }, { 0xd6f8d7509292d603, 0x45a9d2845d3c42b6 },
+    { 0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2 }, { 0xa7f26836f282b732, 0x8e6cac7768d7141e },
+    { 0xd1ef0244af2364ff, 0x3207d795430cd926 }, { 0x8335616aed761f1f, 0x7f44e6bd49e807b8 },
+    { 0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6 }, { 0xcd036837130890a1, 0x36dba887c37a8c0f },
+    { 0x802221226be55a64, 0xc2494954da2c9789 }, { 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c },
+    { 0xc83553c5c8965d3d, 0x6f92829494e5acc7 }, { 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9 },
+    { 0x9c69a97284b578d7, 0xff2a760414536efb }, { 0xc38413cf25e2d70d, 0xfef5138519684aba },
+    { 0xf46518c2ef5b8cd1, 0x7eb258665fc25d69 }, { 0x98bf2f79d5993802, 0xef2f773ffbd97a61 },
+    { 0xbeeefb584aff8603, 0xaafb550ffacfd8fa }, { 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38 },
+    { 0x952ab45cfa97a0b2, 0xdd945a747bf26183 }, { 0xba756174393d88df, 0x94f971119aeef9e4 },
+    { 0xe912b9d1478ceb17, 0x7a37cd5601aab85d }, { 0x91abb422ccb812ee, 0xac62e055c10ab33a },
+    { 0xb616a12b7fe617aa, 0x577b986b314d6009 }, { 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b },
+    { 0x8e41ade9fbebc27d, 0x14588f13be847307 }, { 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8 },
+    { 0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb }, { 0x8aec23d680043bee, 0x25de7bb9480d5854 },
+    { 0xada72ccc20054ae9, 0xaf561aa79a10ae6a }, { 0xd910f7ff28069da4, 0x1b2ba1518094da04 },
+    { 0x87aa9aff79042286, 0x90fb44d2f05d0842 }, { 0xa99541bf57452b28, 0x353a1607ac744a53 },
+    { 0xd3fa922f2d1675f2, 0x42889b8997915ce8 }, { 0x847c9b5d7c2e09b7, 0x69956135febada11 },
+    { 0xa59bc234db398c25, 0x43fab9837e699095 }, { 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb },
+    { 0x8161afb94b44f57d, 0x1d1be0eebac278f5 }, { 0xa1ba1ba79e1632dc, 0x6462d92a69731732 },
+    { 0xca28a291859bbf93, 0x7d7b8f7503cfdcfe }, { 0xfcb2cb35e702af78, 0x5cda735244c3d43e },
+    { 0x9defbf01b061adab, 0x3a0888136afa64a7 }, { 0xc56baec21c7a1916, 0x088aaa1845b8fdd0 },
+    { 0xf6c69a72a3989f5b, 0x8aad549e57273d45 }, { 0x9a3c2087a63f6399, 0x36ac54e2f678864b },
+    { 0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd }, { 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5 },
+    { 0x969eb7c47859e743, 0x9f644ae5a4b1b325 }, { 0xbc4665b596706114, 0x873d5d9f0dde1fee },
+    { 0xeb57ff22fc0c7959, 0xa90cb506d155a7ea }, { 0x9316ff75dd87cbd8, 0x09a7f12442d588f2 },
+    { 0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f }, { 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa },
+    { 0x8fa475791a569d10, 0xf96e017d694487bc }, { 0xb38d92d760ec4455, 0x37c981dcc395a9ac },
+    { 0xe070f78d3927556a, 0x85bbe253f47b1417 }, { 0x8c469ab843b89562, 0x93956d7478ccec8e },
+    { 0xaf58416654a6babb, 0x387ac8d1970027b2 }, { 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e },
+    { 0x88fcf317f22241e2, 0x441fece3bdf81f03 }, { 0xab3c2fddeeaad25a, 0xd527e81cad7626c3 },
+    { 0xd60b3bd56a5586f1, 0x8a71e223d8d3b074 }, { 0x85c7056562757456, 0xf6872d5667844e49 },
+    { 0xa738c6bebb12d16c, 0xb428f8ac016561db }, { 0xd106f86e69d785c7, 0xe13336d701beba52 },
+    { 0x82a45b450226b39c, 0xecc0024661173473 }, { 0xa34d721642b06084, 0x27f002d7f95d0190 },
+    { 0xcc20ce9bd35c78a5, 0x31ec038df7b441f4 }, { 0xff290242c83396ce, 0x7e67047175a15271 },
+    { 0x9f79a169bd203e41, 0x0f0062c6e984d386 }, { 0xc75809c42c684dd1, 0x52c07b78a3e60868 },
+    { 0xf92e0c3537826145, 0xa7709a56ccdf8a82 }, { 0x9bbcc7a142b17ccb, 0x88a66076400bb691 },
+    { 0xc2abf989935ddbfe, 0x6acff893d00ea435 }, { 0xf356f7ebf83552fe, 0x0583f6b8c4124d43 },
+    { 0x98165af37b2153de, 0xc3727a337a8b704a }, { 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c },
+    { 0xeda2ee1c7064130c, 0x1162def06f79df73 }, { 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8 },
+    { 0xb9a74a0637ce2ee1, 0x6d953e2bd7173692 }, { 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437 },
+    { 0x910ab1d4db9914a0, 0x1d9c9892400a22a2 }, { 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b },
+    { 0xe2a0b5dc971f303a, 0x2e44ae64840fd61d }, { 0x8da471a9de737e24, 0x5ceaecfed289e5d2 },
+    { 0xb10d8e1456105dad, 0x7425a83e872c5f47 }, { 0xdd50f1996b947518, 0xd12f124e28f77719 },
+    { 0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f }, { 0xace73cbfdc0bfb7b, 0x636cc64d1001550b },
+    { 0xd8210befd30efa5a, 0x3c47f7e05401aa4e }, { 0x8714a775e3e95c78, 0x65acfaec34810a71 },
+    { 0xa8d9d1535ce3b396, 0x7f1839a741a14d0d }, { 0xd31045a8341ca07c, 0x1ede48111209a050 },
+    { 0x83ea2b892091e44d, 0x934aed0aab460432 }, { 0xa4e4b66b68b65d60, 0xf81da84d5617853f },
+    { 0xce1de40642e3f4b9, 0x36251260ab9d668e }, { 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019 },
+    { 0xa1075a24e4421730, 0xb24cf65b8612f81f }, { 0xc94930ae1d529cfc, 0xdee033f26797b627 },
+    { 0xfb9b7cd9a4a7443c, 0x169840ef017da3b1 }, { 0x9d412e0806e88aa5, 0x8e1f289560ee864e },
+    { 0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2 }, { 0xf5b5d7ec8acb58a2, 0xae10af696774b1db },
+    { 0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29 }, { 0xbff610b0cc6edd3f, 0x17fd090a58d32af3 },
+    { 0xeff394dcff8a948e, 0xddfc4b4cef07f5b0 }, { 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e },
+    { 0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1 }, { 0xea53df5fd18d5513, 0x84c86189216dc5ed },
+    { 0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4 }, { 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1 },
+    { 0xe4d5e82392a40515, 0x0fabaf3feaa5334a }, { 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e },
+    { 0xb2c71d5bca9023f8, 0x743e20e9ef511012 }, { 0xdf78e4b2bd342cf6, 0x914da9246b255416 },
+    { 0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e }, { 0xae9672aba3d0c320, 0xa184ac2473b529b1 },
+    { 0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e }, { 0x8865899617fb1871, 0x7e2fa67c7a658892 },
+    { 0xaa7eebfb9df9de8d, 0xddbb901b98feeab7 }, { 0xd51ea6fa85785631, 0x552a74227f3ea565 },
+    { 0x8533285c936b35de, 0xd53a88958f87275f }, { 0xa67ff273b8460356, 0x8a892abaf368f137 },
+    { 0xd01fef10a657842c, 0x2d2b7569b0432d85 }, { 0x8213f56a67f6b29b, 0x9c3b29620e29fc73 },
+    { 0xa298f2c501f45f42, 0x8349f3ba91b47b8f }, { 0xcb3f2f7642717713, 0x241c70a936219a73 },
+    { 0xfe0efb53d30dd4d7, 0xed238cd383aa0110 }, { 0x9ec95d1463e8a506, 0xf4363804324a40aa },
+    { 0xc67bb4597ce2ce48, 0xb143c6053edcd0d5 }, { 0xf81aa16fdc1b81da, 0xdd94b7868e94050a },
+    { 0x9b10a4e5e9913128, 0xca7cf2b4191c8326 }, { 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0 },
+    { 0xf24a01a73cf2dccf, 0xbc633b39673c8cec }, { 0x976e41088617ca01, 0xd5be0503e085d813 },
+    { 0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18 }, { 0xec9c459d51852ba2, 0xddf8e7d60ed1219e },
+    { 0x93e1ab8252f33b45, 0xcabb90e5c942b503 }, { 0xb8da1662e7b00a17, 0x3d6a751f3b936243 },
+    { 0xe7109bfba19c0c9d, 0x0cc512670a783ad4 }, { 0x906a617d450187e2, 0x27fb2b80668b24c5 },
+    { 0xb484f9dc9641e9da, 0xb1f9f660802dedf6 }, { 0xe1a63853bbd26451, 0x5e7873f8a0396973 },
+    { 0x8d07e33455637eb2, 0xdb0b487b6423e1e8 }, { 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62 },
+    { 0xdc5c5301c56b75f7, 0x7641a140cc7810fb }, { 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d },
+    { 0xac2820d9623bf429, 0x546345fa9fbdcd44 }, { 0xd732290fbacaf133, 0xa97c177947ad4095 },
+    { 0x867f59a9d4bed6c0, 0x49ed8eabcccc485d }, { 0xa81f301449ee8c70, 0x5c68f256bfff5a74 },
+    { 0xd226fc195c6a2f8c, 0x73832eec6fff3111 }, { 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab },
+    { 0xa42e74f3d032f525, 0xba3e7ca8b77f5e55 }, { 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb },
+    { 0x80444b5e7aa7cf85, 0x7980d163cf5b81b3 }, { 0xa0555e361951c366, 0xd7e105bcc332621f },
+    { 0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7 }, { 0xfa856334878fc150, 0xb14f98f6f0feb951 },
+    { 0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3 }, { 0xc3b8358109e84f07, 0x0a862f80ec4700c8 },
+    { 0xf4a642e14c6262c8, 0xcd27bb612758c0fa }, { 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c },
+    { 0xbf21e44003acdd2c, 0xe0470a63e6bd56c3 }, { 0xeeea5d5004981478, 0x1858ccfce06cac74 },
+    { 0x95527a5202df0ccb, 0x0f37801e0c43ebc8 }, { 0xbaa718e68396cffd, 0xd30560258f54e6ba },
+    { 0xe950df20247c83fd, 0x47c6b82ef32a2069 }, { 0x91d28b7416cdd27e, 0x4cdc331d57fa5441 },
+    { 0xb6472e511c81471d, 0xe0133fe4adf8e952 }, { 0xe3d8f9e563a198e5, 0x58180fddd97723a6 },
+    { 0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648 },
+};
+
+/* Eisel-Lemire: correctly rounded w * 10^q for a non-zero w, or 0 if the
+ * result cannot be decided from the 128 bit product.
+ */
+static int json_eisel_lemire(uint64_t w, int64_t q, int negative, double* d)
+{
+    const uint64_t* pow5;
+    uint64_t lower, upper, mantissa, upperbit;
+    int64_t real_exponent;
+    int lz;
+
+    if (q < JSON_POW5_MIN)
+    {
+        *d = (negative ? -0.0 : 0.0);
+        return 1;
+    }
+
+    if (q > JSON_POW5_MAX)
+        return 0;
+
+    lz = json_clz64(w);
+    w <<= lz;
+
+    pow5 = json_pow5_128[q - JSON_POW5_MIN];
+    lower = json_mul128(w, pow5[0], &upper);
+
+    if ((upper & 0x1FF) == 0x1FF)
+    {
+        uint64_t second_hi;
+        json_mul128(w, pow5[1], &second_hi);
+        lower += second_hi;
+        if (second_hi > lower)
+            ++upper;
+    }
+
+    upperbit = upper >> 63;
+    mantissa = upper >> (upperbit + 9);
+    lz += (int)(1 ^ upperbit);
+
+    real_exponent = (((152170 + 65536) * q) >> 16) + 1024 + 63 - lz;
+
+    if (real_exponent <= 0)
+    {
+        if (-real_exponent + 1 >= 64)
+        {
+            *d = (negative ? -0.0 : 0.0);
+            return 1;
+        }
+
+        mantissa >>= -real_exponent + 1;
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+        real_exponent = (mantissa < ((uint64_t)1 << 52)) ? 0 : 1;
+        *d = json_to_double(mantissa & ~((uint64_t)1 << 52), real_exponent, negative);
+        return 1;
+    }
+
+    /* exactly half way between two doubles: round to even */
+    if (lower <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1)
+    {
+        if ((mantissa << (upperbit + 64 - 53 - 2)) == upper)
+            mantissa &= ~(uint64_t)1;
+    }
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+
+    if (mantissa >= ((uint64_t)1 << 53))
+    {
+        mantissa = ((uint64_t)1 << 52);
+        ++real_exponent;
+    }
+
+    if (real_exponent > 2046)
+        return 0;
+
+    *d = json_to_double(mantissa & ~((uint64_t)1 << 52), real_exponent, negative);
+    return 1;
+}
+
+static double json_strtod(const json_char* start, const json_char* end)
+{
+    char buffer[128];
+    char* str = buffer;
+    size_t length = (size_t)(end - start);
+    char decimal_point = localeconv()->decimal_point[0];
+    double d;
+    size_t i;
+
+    if (length >= sizeof(buffer) && !(str = (char*)malloc(length + 1)))
+        return 0;
+
+    /* strtod() honours the locale, json does not */
+    for (i = 0; i < length; ++i)
+        str[i] = (start[i] == '.' ? decimal_point : start[i]);
+
+    str[length] = 0;
+    d = strtod(str, 0);
+
+    if (str != buffer)
+        free(str);
+
+    return d;
+}
+
+static void json_store_number(json_value* value, const json_number* num, const json_char* start)
+{
+    static const double pow10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    double d;
+
+    if (num->is_integer && !num->truncated && num->exponent == 0
+        && num->mantissa <= (uint64_t)JSON_INT_MAX + (uint64_t)num->negative)
+    {
+        value->type = json_integer;
+        value->u.integer = (num->negative ? (json_int_t)(0 - num->mantissa) : (json_int_t)num->mantissa);
+        return;
+    }
+
+    value->type = json_double;
+
+    if (num->mantissa == 0)
+    {
+        value->u.dbl = (num->negative ? -0.0 : 0.0);
+        return;
+    }
+
+    /* Clinger: both operands are exact doubles, so is the rounded result */
+    if (!num->truncated && num->mantissa <= ((uint64_t)1 << 53)
+        && num->exponent >= -22 && num->exponent <= 22)
+    {
+        d = (double)num->mantissa;
+        d = (num->exponent < 0 ? d / pow10[-num->exponent] : d * pow10[num->exponent]);
+        value->u.dbl = (num->negative ? -d : d);
+        return;
+    }
+
+    if (json_eisel_lemire(num->mantissa, num->exponent, num->negative, &d))
+    {
+        double d_upper;
+
+        /* with dropped digits the value lies between mantissa and mantissa + 1 */
+        if (!num->truncated
+            || (json_eisel_lemire(num->mantissa + 1, num->exponent, num->negative, &d_upper) && d == d_upper))
+        {
+            value->u.dbl = d;
+            return;
+        }
+    }
+
+    value->u.dbl = json_strtod(start, num->end);
+}
+
 #define whitespace \
    case '\n': ++ state.cur_line;  state.cur_col = 0; \
    case ' ': case '\t': case '\r'
@@ -229,27 +956,20 @@ flag_escaped = 1 << 4,
 flag_string = 1 << 5,
 flag_need_colon = 1 << 6,
 flag_done = 1 << 7,
-flag_num_negative = 1 << 8,
-flag_num_zero = 1 << 9,
-flag_num_e = 1 << 10,
-flag_num_e_got_sign = 1 << 11,
-flag_num_e_negative = 1 << 12,
-flag_line_comment = 1 << 13,
-flag_block_comment = 1 << 14,
-flag_num_got_decimal = 1 << 15;
+flag_line_comment = 1 << 8,
+flag_block_comment = 1 << 9;
 
-json_value* json_parse_ex(json_settings* settings,
+static json_value* json_parse_state(json_settings* settings,
     const json_char* json,
     size_t length,
-    char* error_buf)
+    char* error_buf,
+    json_value* validate_pool)
 {
     json_char error[json_error_max];
     const json_char* end;
     json_value* top, * root, * alloc = 0;
-    json_state state = { 0 };
+    json_state state = json_state();
     long flags = 0;
-    double num_digits = 0, num_e = 0;
-    double num_fraction = 0;
 
     /* Skip UTF-8 BOM
      */
@@ -278,6 +998,14 @@ json_value* json_parse_ex(json_settings* settings,
     state.uint_max -= 8; /* limit of how much can be added before next check */
     state.ulong_max -= 8;
 
+    if (validate_pool)
+    {
+        if (!state.settings.max_depth || state.settings.max_depth > JSON_VALIDATE_MAX_DEPTH)
+            state.settings.max_depth = JSON_VALIDATE_MAX_DEPTH;
+
+        state.validate_pool = validate_pool;
+    }
+
     for (state.first_pass = 1; state.first_pass >= 0; --state.first_pass)
     {
         json_uchar uchar;
@@ -289,6 +1017,7 @@ json_value* json_parse_ex(json_settings* settings,
         flags = flag_seek_value;
 
         state.cur_line = 1;
+        state.depth = 0;
 
         for (state.ptr = json;; ++state.ptr)
         {
@@ -665,43 +1394,41 @@ json_value* json_parse_ex(json_settings* settings,
 
                         if (isdigit(b) || b == '-')
                         {
+                            json_number num;
+
                             if (!new_value(&state, &top, &root, &alloc, json_integer))
                                 goto e_alloc_failure;
 
-                            if (!state.first_pass)
+                            switch (json_scan_number(state.ptr, end, &num))
                             {
-                                while (isdigit(b) || b == '+' || b == '-'
-                                    || b == 'e' || b == 'E' || b == '.')
-                                {
-                                    if ((++state.ptr) == end)
-                                    {
-                                        b = 0;
-                                        break;
-                                    }
-
-                                    b = *state.ptr;
-                                }
-
-                                flags |= flag_next | flag_reproc;
+                            case json_number_ok:
                                 break;
-                            }
 
-                            flags &= ~(flag_num_negative | flag_num_e |
-                                flag_num_e_got_sign | flag_num_e_negative |
-                                flag_num_zero);
+                            case json_number_e_digit:
+                                snprintf(error, sizeof(error), "%d:%d: Expected digit after `-`", line_and_col);
+                                goto e_failed;
 
-                            num_digits = 0;
-                            num_fraction = 0;
-                            num_e = 0;
+                            case json_number_e_leading_zero:
+                                snprintf(error, sizeof(error), "%d:%d: Unexpected `0` before `%c`", line_and_col, *num.end);
+                                goto e_failed;
 
-                            if (b != '-')
-                            {
-                                flags |= flag_reproc;
-                                break;
-                            }
+                            case json_number_e_fraction:
+                                snprintf(error, sizeof(error), "%d:%d: Expected digit after `.`", line_and_col);
+                                goto e_failed;
 
-                            flags |= flag_num_negative;
-                            continue;
+                            case json_number_e_exponent:
+                                snprintf(error, sizeof(error), "%d:%d: Expected digit after `e`", line_and_col);
+                                goto e_failed;
+                            };
+
+                            /* the value survives into the second pass */
+                            if (state.first_pass)
+                                json_store_number(top, &num, state.ptr);
+
+                            state.ptr = num.end - 1;
+
+                            flags |= flag_next;
+                            break;
                         }
                         else
                         {
@@ -739,6 +1466,10 @@ json_value* json_parse_ex(json_settings* settings,
 
                     case '}':
 
+                        /* the name storage is filled, the slot now holds the index */
+                        if (!state.first_pass)
+                            top->_reserved.object_index = 0;
+
                         flags = (flags & ~flag_need_comma) | flag_next;
                         break;
 
@@ -750,6 +1481,8 @@ json_value* json_parse_ex(json_settings* settings,
                             break;
                         }
 
+                        /* fall through */
+
                     default:
                         snprintf(error, sizeof(error), "%d:%d: Unexpected `%c` in object", line_and_col, b);
                         goto e_failed;
@@ -757,178 +1490,51 @@ json_value* json_parse_ex(json_settings* settings,
 
                     break;
 
-                case json_integer:
-                case json_double:
-
-                    if (isdigit(b))
-                    {
-                        ++num_digits;
-
-                        if (top->type == json_integer || flags & flag_num_e)
-                        {
-                            if (!(flags & flag_num_e))
-                            {
-                                if (flags & flag_num_zero)
-                                {
-                                    snprintf(error, sizeof(error), "%d:%d: Unexpected `0` before `%c`", line_and_col, b);
-                                    goto e_failed;
-                                }
-
-                                if (num_digits == 1 && b == '0')
-                                    flags |= flag_num_zero;
-                            }
-                            else
-                            {
-                                flags |= flag_num_e_got_sign;
-                                num_e = (num_e * 10) + (b - '0');
-                                continue;
-                            }
+                default:
+                    break;
+                };
+            }
 
-                            if (would_overflow(top->u.integer, b))
-                            {
-                                --num_digits;
-                                --state.ptr;
-                                top->type = json_double;
-                                top->u.dbl = (double)top->u.integer;
-                                continue;
-                            }
+            if (flags & flag_reproc)
+            {
+                flags &= ~flag_reproc;
+                --state.ptr;
+            }
 
-                            top->u.integer = (top->u.integer * 10) + (b - '0');
-                            continue;
-                        }
+            if (flags & flag_next)
+            {
+                flags = (flags & ~flag_next) | flag_need_comma;
 
-                        if (flags & flag_num_got_decimal)
-                            num_fraction = (num_fraction * 10) + (b - '0');
-                        else
-                            top->u.dbl = (top->u.dbl * 10) + (b - '0');
+                if (!top->parent)
+                {
+                    /* root value done */
 
-                        continue;
-                    }
+                    flags |= flag_done;
+                    continue;
+                }
 
-                    if (b == '+' || b == '-')
-                    {
-                        if ((flags & flag_num_e) && !(flags & flag_num_e_got_sign))
-                        {
-                            flags |= flag_num_e_got_sign;
+                if (top->parent->type == json_array)
+                    flags |= flag_seek_value;
 
-                            if (b == '-')
-                                flags |= flag_num_e_negative;
+                if (!state.first_pass)
+                {
+                    json_value* parent = top->parent;
 
-                            continue;
-                        }
-                    }
-                    else if (b == '.' && top->type == json_integer)
+                    switch (parent->type)
                     {
-                        if (!num_digits)
-                        {
-                            snprintf(error, sizeof(error), "%d:%d: Expected digit before `.`", line_and_col);
-                            goto e_failed;
-                        }
+                    case json_object:
 
-                        top->type = json_double;
-                        top->u.dbl = (double)top->u.integer;
+                        parent->u.object.values
+                            [parent->u.object.length].value = top;
 
-                        flags |= flag_num_got_decimal;
-                        num_digits = 0;
-                        continue;
-                    }
+                        break;
 
-                    if (!(flags & flag_num_e))
-                    {
-                        if (top->type == json_double)
-                        {
-                            if (!num_digits)
-                            {
-                                snprintf(error, sizeof(error),  "%d:%d: Expected digit after `.`", line_and_col);
-                                goto e_failed;
-                            }
+                    case json_array:
 
-                            top->u.dbl += num_fraction / pow(10.0, num_digits);
-                        }
+                        parent->u.array.values
+                            [parent->u.array.length] = top;
 
-                        if (b == 'e' || b == 'E')
-                        {
-                            flags |= flag_num_e;
-
-                            if (top->type == json_integer)
-                            {
-                                top->type = json_double;
-                                top->u.dbl = (double)top->u.integer;
-                            }
-
-                            num_digits = 0;
-                            flags &= ~flag_num_zero;
-
-                            continue;
-                        }
-                    }
-                    else
-                    {
-                        if (!num_digits)
-                        {
-                            snprintf(error, sizeof(error), "%d:%d: Expected digit after `e`", line_and_col);
-                            goto e_failed;
-                        }
-
-                        top->u.dbl *= pow(10.0, (flags & flag_num_e_negative ? -num_e : num_e));
-                    }
-
-                    if (flags & flag_num_negative)
-                    {
-                        if (top->type == json_integer)
-                            top->u.integer = -top->u.integer;
-                        else
-                            top->u.dbl = -top->u.dbl;
-                    }
-
-                    flags |= flag_next | flag_reproc;
-                    break;
-
-                default:
-                    break;
-                };
-            }
-
-            if (flags & flag_reproc)
-            {
-                flags &= ~flag_reproc;
-                --state.ptr;
-            }
-
-            if (flags & flag_next)
-            {
-                flags = (flags & ~flag_next) | flag_need_comma;
-
-                if (!top->parent)
-                {
-                    /* root value done */
-
-                    flags |= flag_done;
-                    continue;
-                }
-
-                if (top->parent->type == json_array)
-                    flags |= flag_seek_value;
-
-                if (!state.first_pass)
-                {
-                    json_value* parent = top->parent;
-
-                    switch (parent->type)
-                    {
-                    case json_object:
-
-                        parent->u.object.values
-                            [parent->u.object.length].value = top;
-
-                        break;
-
-                    case json_array:
-
-                        parent->u.array.values
-                            [parent->u.array.length] = top;
-
-                        break;
+                        break;
 
                     default:
                         break;
@@ -939,14 +1545,21 @@ json_value* json_parse_ex(json_settings* settings,
                     goto e_overflow;
 
                 top = top->parent;
+                --state.depth;
 
                 continue;
             }
         }
 
+        if (state.validate_pool)
+            return (json_value*)&json_value_none;
+
         alloc = root;
     }
 
+    if (state.settings.settings & json_index_objects)
+        json_object_index_ex(&state.settings, root);
+
     return root;
 
 e_unknown_value:
@@ -956,7 +1569,10 @@ e_unknown_value:
 
 e_alloc_failure:
 
-    strncpy(error, "Memory allocation failure", sizeof(error));
+    if (state.limit_error)
+        snprintf(error, sizeof(error), "%d:%d: %s", line_and_col, state.limit_error);
+    else
+        strncpy(error, "Memory allocation failure", sizeof(error));
     goto e_failed;
 
 e_overflow:
@@ -974,8 +1590,20 @@ e_failed:
             strcpy(error_buf, "Unknown error");
     }
 
+    if (!state.first_pass)
+    {
+        /* unclosed objects still point into their name storage */
+        json_value* open;
+
+        for (open = top; open; open = open->parent)
+        {
+            if (open->type == json_object)
+                open->_reserved.object_index = 0;
+        }
+    }
+
     if (state.first_pass)
-        alloc = root;
+        alloc = (state.validate_pool ? 0 : root);
 
     while (alloc)
     {
@@ -990,65 +1618,1842 @@ e_failed:
     return 0;
 }
 
-json_value* json_parse(const json_char* json, size_t length)
+json_value* json_parse_ex(json_settings* settings,
+    const json_char* json,
+    size_t length,
+    char* error_buf)
 {
-    json_settings settings = { 0 };
-    return json_parse_ex(&settings, json, length, 0);
+    if (settings->settings & json_validate_only)
+    {
+        /* one value per nesting level on the stack instead of allocated values */
+        json_value validate_pool[JSON_VALIDATE_MAX_DEPTH + 1];
+
+        return json_parse_state(settings, json, length, error_buf, validate_pool);
+    }
+
+    return json_parse_state(settings, json, length, error_buf, 0);
 }
 
-void json_value_free_ex(json_settings* settings, json_value* value)
+/* Object index
+ *
+ * Open addressing hash table over the entries of an object. The hash is
+ * computed over the name folded to lower case with trailing digits removed,
+ * so that every json_match mode finds its candidates in the same chain; the
+ * candidates are then verified with the requested mode. Linear probing keeps
+ * entries with the same hash in object order, so the first match wins just
+ * like with a linear scan.
+ */
+
+struct _json_object_index
 {
-    json_value* cur_value;
+    void (*mem_free) (void*, void* user_data);
+    void* user_data;
 
-    if (!value)
-        return;
+    unsigned int mask;
+    unsigned int slots[1];  /* entry index + 1; 0 marks an empty slot */
+};
 
-    value->parent = 0;
+#define json_fold_char(c)  ((c) >= 'A' && (c) <= 'Z' ? (c) + ('a' - 'A') : (c))
+
+static unsigned int json_trim_digits(const json_char* name, unsigned int length)
+{
+    while (length > 0 && json_is_digit(name[length - 1]))
+        --length;
+
+    return length;
+}
+
+static unsigned int json_name_hash(const json_char* name, unsigned int length)
+{
+    unsigned int hash = 2166136261u;
+    unsigned int i;
+
+    length = json_trim_digits(name, length);
+
+    for (i = 0; i < length; ++i)
+        hash = (hash ^ (unsigned char)json_fold_char(name[i])) * 16777619u;
+
+    return hash;
+}
+
+/* Fold the ASCII upper case letters of 8 bytes to lower case. The high bits
+ * are masked off before the additions, so that no carry crosses a byte.
+ */
+static uint64_t json_fold_word(uint64_t word)
+{
+    const uint64_t high_bits = 0x8080808080808080ull;
+    const uint64_t low_bits = word & ~high_bits;
+    const uint64_t at_least_A = low_bits + 0x3f3f3f3f3f3f3f3full;   /* 0x80 - 'A' */
+    const uint64_t above_Z = low_bits + 0x2525252525252525ull;      /* 0x80 - 'Z' - 1 */
+    const uint64_t upper = at_least_A & ~above_Z & ~word & high_bits;
+
+    return word | (upper >> 2);
+}
+
+/* Compare two names of the same length, ignoring ASCII case. Long names are
+ * compared 16 bytes at a time with SSE2, or 8 bytes at a time otherwise.
+ */
+static int json_names_equal_nocase(const json_char* name1, const json_char* name2, unsigned int length)
+{
+    unsigned int i = 0;
+
+#ifdef JSON_HAVE_SSE2
+    const __m128i before_A = _mm_set1_epi8('A' - 1);
+    const __m128i after_Z = _mm_set1_epi8('Z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chunk1 = _mm_loadu_si128((const __m128i*)(name1 + i));
+        __m128i chunk2 = _mm_loadu_si128((const __m128i*)(name2 + i));
+
+        /* bytes >= 0x80 are negative as signed chars and are never folded */
+        chunk1 = _mm_or_si128(chunk1, _mm_and_si128(case_bit,
+            _mm_and_si128(_mm_cmpgt_epi8(chunk1, before_A), _mm_cmplt_epi8(chunk1, after_Z))));
+        chunk2 = _mm_or_si128(chunk2, _mm_and_si128(case_bit,
+            _mm_and_si128(_mm_cmpgt_epi8(chunk2, before_A), _mm_cmplt_epi8(chunk2, after_Z))));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk1, chunk2)) != 0xffff)
+            return 0;
+    }
+#endif
+
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word1, word2;
+
+        memcpy(&word1, name1 + i, sizeof(word1));
+        memcpy(&word2, name2 + i, sizeof(word2));
+
+        if (word1 != word2 && json_fold_word(word1) != json_fold_word(word2))
+            return 0;
+    }
+
+    for (; i < length; ++i)
+    {
+        if (name1[i] != name2[i] && json_fold_char(name1[i]) != json_fold_char(name2[i]))
+            return 0;
+    }
+
+    return 1;
+}
+
+int json_names_match(const json_char* name1, unsigned int length1,
+    const json_char* name2, unsigned int length2,
+    json_match match)
+{
+    if (length1 == length2 && !memcmp(name1, name2, length1))
+        return 1;
+
+    if (match == json_match_exact)
+        return 0;
+
+    if (match == json_match_nodigits)
+    {
+        length1 = json_trim_digits(name1, length1);
+        length2 = json_trim_digits(name2, length2);
+    }
+
+    if (length1 != length2)
+        return 0;
+
+    return json_names_equal_nocase(name1, name2, length1);
+}
+
+static void json_object_index_free(struct _json_object_index* index)
+{
+    index->mem_free(index, index->user_data);
+}
+
+static struct _json_object_index* json_object_index_build(json_settings* settings, json_value* object)
+{
+    struct _json_object_index* index;
+    unsigned int size = 4, i;
+
+    while (size < object->u.object.length * 2)
+        size <<= 1;
+
+    if (!(index = (struct _json_object_index*)settings->mem_alloc
+    (sizeof(struct _json_object_index) + (size - 1) * sizeof(unsigned int), 1, settings->user_data)))
+    {
+        return 0;
+    }
+
+    index->mem_free = settings->mem_free;
+    index->user_data = settings->user_data;
+    index->mask = size - 1;
+
+    for (i = 0; i < object->u.object.length; ++i)
+    {
+        const json_object_entry* entry = &object->u.object.values[i];
+        unsigned int slot = json_name_hash(entry->name, entry->name_length) & index->mask;
+
+        while (index->slots[slot])
+            slot = (slot + 1) & index->mask;
+
+        index->slots[slot] = i + 1;
+    }
+
+    object->_reserved.object_index = index;
+
+    return index;
+}
+
+/* Depth-first walk over the containers of a tree, kept on the heap so that
+ * deeply nested documents do not exhaust the stack
+ */
+typedef struct
+{
+    json_value* container;
+    unsigned int next;  /* index of the next child */
+
+} json_index_frame;
+
+int json_object_index_ex(json_settings* settings, json_value* value)
+{
+    json_settings defaults = json_settings();
+    json_index_frame* stack = 0, *frames;
+    unsigned int depth = 0, capacity = 0, length;
+    int result = 1;
+
+    if (!value || value == &json_value_none)
+        return 1;
+
+    if (!settings)
+        settings = &defaults;
+
+    if (!settings->mem_alloc || !settings->mem_free)
+    {
+        defaults = *settings;
+        defaults.mem_alloc = default_alloc;
+        defaults.mem_free = default_free;
+        settings = &defaults;
+    }
 
     while (value)
     {
-        switch (value->type)
+        if (value->type == json_object && value->u.object.length >= JSON_INDEX_MIN_LENGTH
+            && !value->_reserved.object_index && !json_object_index_build(settings, value))
         {
-        case json_array:
+            result = 0;
+        }
 
-            if (!value->u.array.length)
+        if ((value->type == json_object && value->u.object.length) || (value->type == json_array && value->u.array.length))
+        {
+            if (depth == capacity)
             {
-                settings->mem_free(value->u.array.values, settings->user_data);
-                break;
+                if (!(frames = (json_index_frame*)settings->mem_alloc
+                (sizeof(json_index_frame) * (capacity ? capacity * 2 : 16), 0, settings->user_data)))
+                {
+                    result = 0;
+                    break;
+                }
+
+                if (stack)
+                {
+                    memcpy(frames, stack, sizeof(json_index_frame) * depth);
+                    settings->mem_free(stack, settings->user_data);
+                }
+
+                stack = frames;
+                capacity = (capacity ? capacity * 2 : 16);
             }
 
-            value = value->u.array.values[--value->u.array.length];
-            continue;
+            stack[depth].container = value;
+            stack[depth].next = 0;
+            ++depth;
+        }
 
-        case json_object:
+        /* continue with the next child of the innermost container that has one left */
+        value = 0;
 
-            if (!value->u.object.length)
+        while (depth && !value)
+        {
+            json_index_frame* frame = &stack[depth - 1];
+
+            if (frame->container->type == json_object)
             {
-                settings->mem_free(value->u.object.values, settings->user_data);
-                break;
+                length = frame->container->u.object.length;
+                value = (frame->next < length ? frame->container->u.object.values[frame->next].value : 0);
+            }
+            else
+            {
+                length = frame->container->u.array.length;
+                value = (frame->next < length ? frame->container->u.array.values[frame->next] : 0);
             }
 
-            value = value->u.object.values[--value->u.object.length].value;
-            continue;
+            if (value)
+                ++frame->next;
+            else
+                --depth;
+        }
+    }
 
-        case json_string:
+    if (stack)
+        settings->mem_free(stack, settings->user_data);
 
-            settings->mem_free(value->u.string.ptr, settings->user_data);
-            break;
+    return result;
+}
 
-        default:
-            break;
-        };
+const json_object_entry* json_object_find(const json_value* object,
+    const json_char* name,
+    unsigned int name_length,
+    json_match match)
+{
+    const json_object_entry* entry;
+    const struct _json_object_index* index;
+    unsigned int i;
 
-        cur_value = value;
-        value = value->parent;
-        settings->mem_free(cur_value, settings->user_data);
+    if (!object || object->type != json_object)
+        return 0;
+
+    /* only objects of at least JSON_INDEX_MIN_LENGTH entries have an index */
+    if (object->u.object.length >= JSON_INDEX_MIN_LENGTH && (index = object->_reserved.object_index) != 0)
+    {
+        i = json_name_hash(name, name_length) & index->mask;
+
+        for (; index->slots[i]; i = (i + 1) & index->mask)
+        {
+            entry = &object->u.object.values[index->slots[i] - 1];
+
+            if (json_names_match(entry->name, entry->name_length, name, name_length, match))
+                return entry;
+        }
+
+        return 0;
+    }
+
+    for (i = 0; i < object->u.object.length; ++i)
+    {
+        entry = &object->u.object.values[i];
+
+        if (json_names_match(entry->name, entry->name_length, name, name_length, match))
+            return entry;
     }
+
+    return 0;
 }
 
-void json_value_free(json_value* value)
+/* Reparse
+ *
+ * Walks the new json text and the previous tree side by side. As long as the
+ * text has the same shape as the tree - same containers, same names in the
+ * same order, same array lengths - scalar values are updated in place; a
+ * scalar may change between integer, double, boolean and null. Strings are
+ * overwritten in place unless they grow. Object indexes stay valid, as the
+ * entries do not move. Anything else makes the walk give up, and the text is
+ * parsed from scratch.
+ */
+
+#ifndef JSON_REPARSE_MAX_DEPTH
+#define JSON_REPARSE_MAX_DEPTH 32
+#endif
+
+#define json_reparse_skip_whitespace(ptr, end) \
+   while ((ptr) < (end) && (*(ptr) == ' ' || *(ptr) == '\t' || *(ptr) == '\n' || *(ptr) == '\r')) ++(ptr)
+
+#define json_is_scalar(type) \
+   ((type) == json_integer || (type) == json_double || (type) == json_boolean || (type) == json_null)
+
+/* Decode the string starting after the opening quote; string is 0 to measure only */
+static int json_reparse_string(const json_char** ptr, const json_char* end, json_char* string, unsigned int* length)
 {
-    json_settings settings = { 0 };
-    settings.mem_free = default_free;
-    json_value_free_ex(&settings, value);
+    const json_char* p = *ptr;
+    unsigned int n = 0;
+    json_uchar uchar;
+    int i;
+
+    while (p < end && *p != '"')
+    {
+        if (*p != '\\')
+        {
+            if (string)
+                string[n] = *p;
+
+            ++n, ++p;
+            continue;
+        }
+
+        if (++p == end)
+            return 0;
+
+        switch (*p++)
+        {
+        case 'b':  if (string) string[n] = '\b';  ++n;  break;
+        case 'f':  if (string) string[n] = '\f';  ++n;  break;
+        case 'n':  if (string) string[n] = '\n';  ++n;  break;
+        case 'r':  if (string) string[n] = '\r';  ++n;  break;
+        case 't':  if (string) string[n] = '\t';  ++n;  break;
+        case 'u':
+
+            if (end - p < 4)
+                return 0;
+
+            for (uchar = 0, i = 0; i < 4; ++i, ++p)
+            {
+                if (hex_value(*p) == 0xFF)
+                    return 0;
+
+                uchar = (uchar << 4) | hex_value(*p);
+            }
+
+            if ((uchar & 0xF800) == 0xD800)
+            {
+                json_uchar uchar2 = 0;
+
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u')
+                    return 0;
+
+                for (p += 2, i = 0; i < 4; ++i, ++p)
+                {
+                    if (hex_value(*p) == 0xFF)
+                        return 0;
+
+                    uchar2 = (uchar2 << 4) | hex_value(*p);
+                }
+
+                uchar = 0x010000 | ((uchar & 0x3FF) << 10) | (uchar2 & 0x3FF);
+            }
+
+            if (sizeof(json_char) >= sizeof(json_uchar) || (uchar <= 0x7F))
+            {
+                if (string)
+                    string[n] = (json_char)uchar;
+
+                n += 1;
+            }
+            else if (uchar <= 0x7FF)
+            {
+                if (string)
+                {
+                    string[n + 0] = 0xC0 | (uchar >> 6);
+                    string[n + 1] = 0x80 | (uchar & 0x3F);
+                }
+
+                n += 2;
+            }
+            else if (uchar <= 0xFFFF)
+            {
+                if (string)
+                {
+                    string[n + 0] = 0xE0 | (uchar >> 12);
+                    string[n + 1] = 0x80 | ((uchar >> 6) & 0x3F);
+                    string[n + 2] = 0x80 | (uchar & 0x3F);
+                }
+
+                n += 3;
+            }
+            else
+            {
+                if (string)
+                {
+                    string[n + 0] = 0xF0 | (uchar >> 18);
+                    string[n + 1] = 0x80 | ((uchar >> 12) & 0x3F);
+                    string[n + 2] = 0x80 | ((uchar >> 6) & 0x3F);
+                    string[n + 3] = 0x80 | (uchar & 0x3F);
+                }
+
+                n += 4;
+            }
+
+            break;
+
+        default:
+            if (string)
+                string[n] = p[-1];
+
+            ++n;
+            break;
+        };
+    }
+
+    if (p == end)
+        return 0;
+
+    *ptr = p + 1;
+    *length = n;
+    return 1;
+}
+
+/* Returns 1 if the tree has been updated to the text, 0 if the text must be parsed from scratch */
+static int json_reparse_walk(json_state* state, json_value* root, const json_char* ptr, const json_char* end)
+{
+    json_value* stack[JSON_REPARSE_MAX_DEPTH];
+    unsigned int index[JSON_REPARSE_MAX_DEPTH];
+    json_value* value = root, * container;
+    json_object_entry* entry;
+    const json_char* start;
+    unsigned int length;
+    int depth = -1;
+
+    if (end - ptr >= 3 && ((unsigned char)ptr[0]) == 0xEF
+        && ((unsigned char)ptr[1]) == 0xBB
+        && ((unsigned char)ptr[2]) == 0xBF)
+    {
+        ptr += 3;
+    }
+
+    for (;;)
+    {
+        /* value expected, matching the node in value */
+        json_reparse_skip_whitespace(ptr, end);
+
+        if (ptr == end)
+            return 0;
+
+        switch (*ptr)
+        {
+        case '{':
+        case '[':
+
+            if (value->type != (*ptr == '{' ? json_object : json_array) || depth + 1 == JSON_REPARSE_MAX_DEPTH)
+                return 0;
+
+            ++ptr;
+            ++depth;
+            stack[depth] = value;
+            index[depth] = 0;
+
+            json_reparse_skip_whitespace(ptr, end);
+
+            if (ptr < end && *ptr == (value->type == json_object ? '}' : ']'))
+            {
+                if (value->u.object.length != 0)
+                    return 0;
+
+                ++ptr;
+                --depth;
+                break;
+            }
+
+            goto next_child;
+
+        case '"':
+
+            if (value->type != json_string)
+                return 0;
+
+            start = ++ptr;
+
+            if (!json_reparse_string(&ptr, end, 0, &length) || length > state->uint_max)
+                return 0;
+
+            if (length > value->u.string.length)
+            {
+                json_char* string;
+
+                if (!(string = (json_char*)state->settings.mem_alloc((length + 1) * sizeof(json_char), 0, state->settings.user_data)))
+                    return 0;
+
+                state->settings.mem_free(value->u.string.ptr, state->settings.user_data);
+                value->u.string.ptr = string;
+            }
+
+            json_reparse_string(&start, end, value->u.string.ptr, &length);
+            value->u.string.ptr[length] = 0;
+            value->u.string.length = length;
+            break;
+
+        case 't':
+        case 'f':
+        case 'n':
+
+            if (!json_is_scalar(value->type))
+                return 0;
+
+            length = (*ptr == 'f' ? 5 : 4);
+
+            if ((size_t)(end - ptr) < length || memcmp(ptr, (*ptr == 't' ? "true" : *ptr == 'f' ? "false" : "null"), length))
+                return 0;
+
+            value->type = (*ptr == 'n' ? json_null : json_boolean);
+            value->u.boolean = (*ptr == 't');
+            ptr += length;
+            break;
+
+        default:
+
+            if (json_is_digit(*ptr) || *ptr == '-')
+            {
+                json_number num;
+
+                if (!json_is_scalar(value->type) || json_scan_number(ptr, end, &num) != json_number_ok)
+                    return 0;
+
+                json_store_number(value, &num, ptr);
+                ptr = num.end;
+                break;
+            }
+
+            return 0;
+        };
+
+        /* value done, continue with the enclosing container */
+        for (;;)
+        {
+            json_reparse_skip_whitespace(ptr, end);
+
+            if (depth < 0)
+                return ptr == end;
+
+            container = stack[depth];
+            ++index[depth];
+
+            if (ptr < end && *ptr == ',')
+            {
+                ++ptr;
+                json_reparse_skip_whitespace(ptr, end);
+
+                /* a trailing comma is tolerated, as by json_parse_ex */
+                if (ptr == end || *ptr != (container->type == json_object ? '}' : ']'))
+                    break;
+            }
+
+            if (ptr == end || *ptr != (container->type == json_object ? '}' : ']')
+                || index[depth] != container->u.object.length)
+            {
+                return 0;
+            }
+
+            ++ptr;
+            --depth;
+        }
+
+    next_child:
+
+        container = stack[depth];
+
+        if (index[depth] >= container->u.object.length)
+            return 0;
+
+        if (container->type == json_array)
+        {
+            value = container->u.array.values[index[depth]];
+            continue;
+        }
+
+        /* the name must match the entry at the same position */
+        entry = &container->u.object.values[index[depth]];
+
+        json_reparse_skip_whitespace(ptr, end);
+
+        if (ptr == end || *ptr != '"')
+            return 0;
+
+        start = ++ptr;
+
+        while (ptr < end && *ptr != '"' && *ptr != '\\')
+            ++ptr;
+
+        if (ptr == end || *ptr != '"' || (unsigned int)(ptr - start) != entry->name_length
+            || memcmp(start, entry->name, entry->name_length * sizeof(json_char)))
+        {
+            return 0;
+        }
+
+        ++ptr;
+        json_reparse_skip_whitespace(ptr, end);
+
+        if (ptr == end || *ptr != ':')
+            return 0;
+
+        ++ptr;
+        value = entry->value;
+    }
+}
+
+json_value* json_reparse_ex(json_settings* settings,
+    json_value* previous,
+    const json_char* json,
+    size_t length,
+    char* error_buf)
+{
+    json_state state = json_state();
+
+    if (previous)
+    {
+        memcpy(&state.settings, settings, sizeof(json_settings));
+
+        if (!state.settings.mem_alloc)
+            state.settings.mem_alloc = default_alloc;
+
+        if (!state.settings.mem_free)
+            state.settings.mem_free = default_free;
+
+        memset(&state.uint_max, 0xFF, sizeof(state.uint_max));
+        state.uint_max -= 8;
+
+        if (!(state.settings.settings & json_enable_comments)
+            && json_reparse_walk(&state, previous, json, json + length))
+        {
+            if (state.settings.settings & json_index_objects)
+                json_object_index_ex(&state.settings, previous);
+
+            return previous;
+        }
+
+        json_value_free_ex(&state.settings, previous);
+    }
+
+    return json_parse_ex(settings, json, length, error_buf);
+}
+
+json_value* json_parse(const json_char* json, size_t length)
+{
+    json_settings settings = json_settings();
+    return json_parse_ex(&settings, json, length, 0);
+}
+
+void json_value_free_ex(json_settings* settings, json_value* value)
+{
+    json_value* cur_value;
+
+    if (!value || value == &json_value_none)
+        return;
+
+    value->parent = 0;
+
+    while (value)
+    {
+        switch (value->type)
+        {
+        case json_array:
+
+            if (!value->u.array.length)
+            {
+                settings->mem_free(value->u.array.values, settings->user_data);
+                break;
+            }
+
+            value = value->u.array.values[--value->u.array.length];
+            continue;
+
+        case json_object:
+
+            if (!value->u.object.length)
+            {
+                if (value->_reserved.object_index)
+                    json_object_index_free(value->_reserved.object_index);
+
+                settings->mem_free(value->u.object.values, settings->user_data);
+                break;
+            }
+
+            value = value->u.object.values[--value->u.object.length].value;
+            continue;
+
+        case json_string:
+
+            settings->mem_free(value->u.string.ptr, settings->user_data);
+            break;
+
+        default:
+            break;
+        };
+
+        cur_value = value;
+        value = value->parent;
+        settings->mem_free(cur_value, settings->user_data);
+    }
+}
+
+void json_value_free(json_value* value)
+{
+    json_settings settings = json_settings();
+    settings.mem_free = default_free;
+    json_value_free_ex(&settings, value);
+}
+
+/* Stream parser
+ *
+ * Single pass, resumable variant of json_parse_ex for json text that arrives
+ * in pieces. As container and string sizes are not known up front, the
+ * children of open containers, object names and string contents are collected
+ * in scratch buffers owned by the stream; the final blocks are allocated once
+ * a string or container closes. Object entries and their names share one
+ * block, exactly as laid out by json_parse_ex.
+ *
+ * A stream can also parse into the tree of a previous document, see
+ * json_stream_reuse. While the text matches that tree in structure, the
+ * frames walk the previous tree and its values are updated in place, with
+ * the same rules as json_reparse_ex. At the first difference, the matched
+ * part of the tree is moved into the scratch buffers as if it had been built
+ * from the text, the rest of it is freed, and parsing continues as usual.
+ */
+
+typedef enum
+{
+    json_stream_st_value,           /* seeking a value */
+    json_stream_st_first_value,     /* seeking the first array value or ] */
+    json_stream_st_name,            /* seeking an object name */
+    json_stream_st_first_name,      /* seeking the first object name or } */
+    json_stream_st_colon,           /* seeking : after an object name */
+    json_stream_st_next,            /* seeking , or the closing bracket */
+    json_stream_st_string,          /* inside a string or name */
+    json_stream_st_token,           /* inside a number or literal */
+    json_stream_st_done,            /* root value complete, trailing whitespace only */
+    json_stream_st_failed
+
+} json_stream_state;
+
+typedef struct
+{
+    json_value* value;
+    size_t first;                   /* first child in the children or entries scratch; while matching, index of the next child */
+    size_t first_text;              /* first name byte in the text scratch */
+
+} json_stream_frame;
+
+struct _json_stream
+{
+    json_state state;
+    json_stream_state st;
+    json_value* root;
+    json_value* previous;           /* tree updated in place while the text matches it, or 0 */
+
+    json_stream_frame* frames;
+    size_t num_frames, max_frames;
+
+    json_value** children;
+    size_t num_children, max_children;
+
+    json_object_entry* entries;     /* names are stored as offsets into text */
+    size_t num_entries, max_entries;
+
+    json_char* text;
+    size_t text_length, max_text;
+
+    size_t token_start;             /* start of the current string, name or token in text */
+    int token_is_name;
+    int escape;                     /* 1: after \, 2: in \u, 3: \ of a low surrogate expected, 4: u expected */
+    int hex_digits;
+    json_uchar uchar, uchar_high;
+
+    size_t offset;                  /* number of bytes consumed by previous calls */
+    size_t line_offset;             /* offset of the current line */
+
+    json_char error[json_error_max];
+};
+
+#define json_stream_grow(stream, buffer, max, needed) \
+    (((needed) <= (max)) || json_stream_realloc((stream), (void**)&(buffer), &(max), (needed), sizeof(*(buffer))))
+
+static int json_stream_realloc(json_stream* stream, void** buffer, size_t* max, size_t needed, size_t size)
+{
+    size_t new_max = (*max ? *max : 16);
+    void* new_buffer;
+
+    while (new_max < needed)
+        new_max *= 2;
+
+    if (!(new_buffer = stream->state.settings.mem_alloc(new_max * size, 0, stream->state.settings.user_data)))
+        return 0;
+
+    if (*buffer)
+    {
+        memcpy(new_buffer, *buffer, *max * size);
+        stream->state.settings.mem_free(*buffer, stream->state.settings.user_data);
+    }
+
+    *buffer = new_buffer;
+    *max = new_max;
+    return 1;
+}
+
+static int json_stream_text(json_stream* stream, const json_char* text, size_t length)
+{
+    if (!json_stream_grow(stream, stream->text, stream->max_text, stream->text_length + length))
+        return 0;
+
+    memcpy(stream->text + stream->text_length, text, length * sizeof(json_char));
+    stream->text_length += length;
+    return 1;
+}
+
+static int json_stream_uchar(json_stream* stream, json_uchar uchar)
+{
+    json_char utf8[4];
+
+    if (sizeof(json_char) >= sizeof(json_uchar) || (uchar <= 0x7F))
+    {
+        utf8[0] = (json_char)uchar;
+        return json_stream_text(stream, utf8, 1);
+    }
+
+    if (uchar <= 0x7FF)
+    {
+        utf8[0] = 0xC0 | (uchar >> 6);
+        utf8[1] = 0x80 | (uchar & 0x3F);
+        return json_stream_text(stream, utf8, 2);
+    }
+
+    if (uchar <= 0xFFFF)
+    {
+        utf8[0] = 0xE0 | (uchar >> 12);
+        utf8[1] = 0x80 | ((uchar >> 6) & 0x3F);
+        utf8[2] = 0x80 | (uchar & 0x3F);
+        return json_stream_text(stream, utf8, 3);
+    }
+
+    utf8[0] = 0xF0 | (uchar >> 18);
+    utf8[1] = 0x80 | ((uchar >> 12) & 0x3F);
+    utf8[2] = 0x80 | ((uchar >> 6) & 0x3F);
+    utf8[3] = 0x80 | (uchar & 0x3F);
+    return json_stream_text(stream, utf8, 4);
+}
+
+static json_value* json_stream_value(json_stream* stream, json_type type)
+{
+    json_value* value;
+
+    if (!json_check_limits(&stream->state, (unsigned int)stream->num_frames, type))
+        return 0;
+
+    if (!(value = (json_value*)json_alloc(&stream->state, sizeof(json_value) + stream->state.settings.value_extra, 1)))
+        return 0;
+
+    value->type = type;
+    value->parent = (stream->num_frames ? stream->frames[stream->num_frames - 1].value : 0);
+
+#ifdef JSON_TRACK_SOURCE
+    value->line = stream->state.cur_line;
+    value->col = stream->state.cur_col;
+#endif
+
+    return value;
+}
+
+/* The node of the previous tree at the position of the next value or name, or 0 if there is none */
+static json_value* json_stream_expected(json_stream* stream)
+{
+    json_stream_frame* frame;
+    json_value* container;
+
+    if (!stream->num_frames)
+        return stream->previous;
+
+    frame = &stream->frames[stream->num_frames - 1];
+    container = frame->value;
+
+    if (frame->first >= container->u.object.length)
+        return 0;
+
+    return (container->type == json_array ? container->u.array.values[frame->first]
+        : container->u.object.values[frame->first].value);
+}
+
+/* The text no longer matches the previous tree: hand the matched part of it over to the scratch
+ * buffers, as if it had been built from the text, and free the rest. While matching, the text
+ * scratch holds nothing but the current token, which is moved behind the names.
+ */
+static int json_stream_diverge(json_stream* stream)
+{
+    json_settings* settings = &stream->state.settings;
+    size_t token_length = stream->text_length;
+    size_t num_children = stream->num_children, num_entries = stream->num_entries, text_length = stream->text_length;
+    size_t i, a, b;
+    unsigned int j, matched, count;
+    json_value* container, * nested;
+    json_object_entry* entry;
+    json_char c;
+
+    if (!stream->num_frames)
+    {
+        json_value_free_ex(settings, stream->previous);
+        stream->previous = 0;
+        return 1;
+    }
+
+    /* reserve the scratch space first, so that the conversion cannot fail halfway */
+    for (i = 0; i < stream->num_frames; ++i)
+    {
+        container = stream->frames[i].value;
+        count = (unsigned int)stream->frames[i].first + 1;
+
+        if (container->type == json_array)
+        {
+            num_children += count;
+            continue;
+        }
+
+        num_entries += count;
+
+        for (j = 0; j < count && j < container->u.object.length; ++j)
+            text_length += container->u.object.values[j].name_length + 1;
+    }
+
+    if (!json_stream_grow(stream, stream->children, stream->max_children, num_children)
+        || !json_stream_grow(stream, stream->entries, stream->max_entries, num_entries)
+        || !json_stream_grow(stream, stream->text, stream->max_text, text_length))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < stream->num_frames; ++i)
+    {
+        json_stream_frame* frame = &stream->frames[i];
+
+        container = frame->value;
+        matched = (unsigned int)frame->first;
+        nested = (i + 1 < stream->num_frames ? stream->frames[i + 1].value : 0);
+
+        if (container->type == json_array)
+        {
+            frame->first = stream->num_children;
+
+            for (j = 0; j < container->u.array.length; ++j)
+            {
+                if (j < matched)
+                    stream->children[stream->num_children++] = container->u.array.values[j];
+                else if (container->u.array.values[j] != nested)
+                    json_value_free_ex(settings, container->u.array.values[j]);
+            }
+
+            settings->mem_free(container->u.array.values, settings->user_data);
+            container->u.array.values = 0;
+            container->u.array.length = 0;
+            continue;
+        }
+
+        /* the name of an open container, or of the value being parsed, has been matched already */
+        count = matched + (nested || stream->st == json_stream_st_value ? 1 : 0);
+
+        frame->first = stream->num_entries;
+        frame->first_text = stream->text_length - token_length;
+
+        for (j = 0; j < container->u.object.length; ++j)
+        {
+            entry = &container->u.object.values[j];
+
+            if (j < count)
+            {
+                json_object_entry* copy = &stream->entries[stream->num_entries++];
+
+                copy->name = (json_char*)(stream->text_length - token_length);
+                copy->name_length = entry->name_length;
+                copy->value = (j < matched ? entry->value : 0);
+
+                memcpy(stream->text + stream->text_length, entry->name, entry->name_length * sizeof(json_char));
+                stream->text_length += entry->name_length;
+                stream->text[stream->text_length++] = 0;
+            }
+
+            if (j >= matched && entry->value != nested)
+                json_value_free_ex(settings, entry->value);
+        }
+
+        if (container->_reserved.object_index)
+            json_object_index_free(container->_reserved.object_index);
+
+        settings->mem_free(container->u.object.values, settings->user_data);
+        container->_reserved.object_index = 0;
+        container->u.object.values = 0;
+        container->u.object.length = 0;
+    }
+
+    /* rotate the token behind the names: reverse all, then both parts */
+    for (a = 0, b = stream->text_length; a + 1 < b; ++a, --b)
+        c = stream->text[a], stream->text[a] = stream->text[b - 1], stream->text[b - 1] = c;
+
+    for (a = 0, b = stream->text_length - token_length; a + 1 < b; ++a, --b)
+        c = stream->text[a], stream->text[a] = stream->text[b - 1], stream->text[b - 1] = c;
+
+    for (a = stream->text_length - token_length, b = stream->text_length; a + 1 < b; ++a, --b)
+        c = stream->text[a], stream->text[a] = stream->text[b - 1], stream->text[b - 1] = c;
+
+    stream->token_start = stream->text_length - token_length;
+    stream->previous = 0;
+    return 1;
+}
+
+/* Check that the next value matches the previous tree in type, or stop matching; scalars are interchangeable */
+static int json_stream_expect(json_stream* stream, json_type type)
+{
+    json_value* expected;
+
+    if (!stream->previous)
+        return 1;
+
+    expected = json_stream_expected(stream);
+
+    if (expected && (expected->type == type || (json_is_scalar(type) && json_is_scalar(expected->type))))
+        return 1;
+
+    return json_stream_diverge(stream);
+}
+
+/* A value of the previous tree has been updated; continue with the enclosing container */
+static int json_stream_matched(json_stream* stream)
+{
+    if (!stream->num_frames)
+    {
+        stream->root = stream->previous;
+        stream->previous = 0;
+        stream->st = json_stream_st_done;
+        return 1;
+    }
+
+    ++stream->frames[stream->num_frames - 1].first;
+    stream->st = json_stream_st_next;
+    return 1;
+}
+
+/* Hand a complete value to the enclosing container, or make it the root */
+static int json_stream_push(json_stream* stream, json_value* value)
+{
+    json_stream_frame* frame;
+
+    if (!stream->num_frames)
+    {
+        stream->root = value;
+        stream->st = json_stream_st_done;
+        return 1;
+    }
+
+    frame = &stream->frames[stream->num_frames - 1];
+
+    if (frame->value->type == json_array)
+    {
+        if (stream->num_children - frame->first > stream->state.uint_max
+            || !json_stream_grow(stream, stream->children, stream->max_children, stream->num_children + 1))
+        {
+            json_value_free_ex(&stream->state.settings, value);
+            return 0;
+        }
+
+        stream->children[stream->num_children++] = value;
+    }
+    else
+        stream->entries[stream->num_entries - 1].value = value;
+
+    stream->st = json_stream_st_next;
+    return 1;
+}
+
+static int json_stream_open(json_stream* stream, json_type type)
+{
+    json_stream_frame* frame;
+    json_value* value;
+
+    if (!json_stream_expect(stream, type))
+        return 0;
+
+    if (stream->previous)
+    {
+        value = json_stream_expected(stream);
+
+        if (!json_check_limits(&stream->state, (unsigned int)stream->num_frames, type)
+            || !json_stream_grow(stream, stream->frames, stream->max_frames, stream->num_frames + 1))
+        {
+            return 0;
+        }
+
+        frame = &stream->frames[stream->num_frames++];
+        frame->value = value;
+        frame->first = frame->first_text = 0;
+
+        stream->st = (type == json_array ? json_stream_st_first_value : json_stream_st_first_name);
+        return 1;
+    }
+
+    if (!(value = json_stream_value(stream, type)))
+        return 0;
+
+    if (!json_stream_grow(stream, stream->frames, stream->max_frames, stream->num_frames + 1))
+    {
+        stream->state.settings.mem_free(value, stream->state.settings.user_data);
+        return 0;
+    }
+
+    frame = &stream->frames[stream->num_frames++];
+    frame->value = value;
+    frame->first = (type == json_array ? stream->num_children : stream->num_entries);
+    frame->first_text = stream->text_length;
+
+    stream->st = (type == json_array ? json_stream_st_first_value : json_stream_st_first_name);
+    return 1;
+}
+
+static int json_stream_close(json_stream* stream)
+{
+    json_stream_frame* frame = &stream->frames[stream->num_frames - 1];
+    json_value* value = frame->value;
+    unsigned int i, length;
+
+    if (stream->previous)
+    {
+        if (frame->first == value->u.object.length)
+        {
+            --stream->num_frames;
+            return json_stream_matched(stream);
+        }
+
+        if (!json_stream_diverge(stream))
+            return 0;
+    }
+
+    if (value->type == json_array)
+    {
+        length = (unsigned int)(stream->num_children - frame->first);
+
+        if (length)
+        {
+            if (!(value->u.array.values = (json_value**)json_alloc
+            (&stream->state, length * sizeof(json_value*), 0)))
+            {
+                return 0;
+            }
+
+            memcpy(value->u.array.values, stream->children + frame->first, length * sizeof(json_value*));
+            value->u.array.length = length;
+            stream->num_children = frame->first;
+        }
+    }
+    else
+    {
+        length = (unsigned int)(stream->num_entries - frame->first);
+
+        if (length)
+        {
+            size_t values_size = length * sizeof(json_object_entry);
+            size_t names_size = (stream->text_length - frame->first_text) * sizeof(json_char);
+            json_char* names;
+
+            if (!(value->u.object.values = (json_object_entry*)json_alloc
+            (&stream->state, values_size + names_size, 0)))
+            {
+                return 0;
+            }
+
+            names = (json_char*)(((char*)value->u.object.values) + values_size);
+            memcpy(names, stream->text + frame->first_text, names_size);
+
+            for (i = 0; i < length; ++i)
+            {
+                value->u.object.values[i] = stream->entries[frame->first + i];
+                value->u.object.values[i].name = names + ((size_t)value->u.object.values[i].name - frame->first_text);
+            }
+
+            value->u.object.length = length;
+            stream->num_entries = frame->first;
+            stream->text_length = frame->first_text;
+        }
+    }
+
+    --stream->num_frames;
+    return json_stream_push(stream, value);
+}
+
+/* A string or name closed */
+static int json_stream_string(json_stream* stream)
+{
+    size_t length = stream->text_length - stream->token_start;
+    json_value* value;
+
+    if (stream->token_is_name)
+    {
+        json_object_entry* entry;
+        json_char terminator = 0;
+
+        if (stream->previous)
+        {
+            /* the name must match the entry at the same position */
+            json_stream_frame* frame = &stream->frames[stream->num_frames - 1];
+
+            entry = &frame->value->u.object.values[frame->first];
+
+            if (entry->name_length == length
+                && !memcmp(entry->name, stream->text + stream->token_start, length * sizeof(json_char)))
+            {
+                stream->text_length = stream->token_start;
+                stream->st = json_stream_st_colon;
+                return 1;
+            }
+
+            if (!json_stream_diverge(stream))
+                return 0;
+        }
+
+        if (!json_stream_text(stream, &terminator, 1)
+            || !json_stream_grow(stream, stream->entries, stream->max_entries, stream->num_entries + 1))
+        {
+            return 0;
+        }
+
+        entry = &stream->entries[stream->num_entries++];
+        entry->name = (json_char*)(size_t)stream->token_start;
+        entry->name_length = (unsigned int)length;
+        entry->value = 0;
+
+        stream->st = json_stream_st_colon;
+        return 1;
+    }
+
+    if (stream->previous)
+    {
+        /* update the string of the previous tree in place; it is only reallocated if it grows */
+        value = json_stream_expected(stream);
+
+        if (!json_check_limits(&stream->state, (unsigned int)stream->num_frames, json_string))
+            return 0;
+
+        if (length > value->u.string.length)
+        {
+            json_char* string;
+
+            if (!(string = (json_char*)stream->state.settings.mem_alloc((length + 1) * sizeof(json_char), 0, stream->state.settings.user_data)))
+                return 0;
+
+            stream->state.settings.mem_free(value->u.string.ptr, stream->state.settings.user_data);
+            value->u.string.ptr = string;
+        }
+
+        if (length > 0)
+            memcpy(value->u.string.ptr, stream->text + stream->token_start, length * sizeof(json_char));
+        value->u.string.ptr[length] = 0;
+        value->u.string.length = (unsigned int)length;
+
+        stream->text_length = stream->token_start;
+        return json_stream_matched(stream);
+    }
+
+    if (!(value = json_stream_value(stream, json_string)))
+        return 0;
+
+    if (!(value->u.string.ptr = (json_char*)json_alloc(&stream->state, (length + 1) * sizeof(json_char), 0)))
+    {
+        stream->state.settings.mem_free(value, stream->state.settings.user_data);
+        return 0;
+    }
+
+    if (length > 0)
+        memcpy(value->u.string.ptr, stream->text + stream->token_start, length * sizeof(json_char));
+    value->u.string.ptr[length] = 0;
+    value->u.string.length = (unsigned int)length;
+
+    stream->text_length = stream->token_start;
+    return json_stream_push(stream, value);
+}
+
+/* A number or literal closed; returns -1 if the token is not a valid value */
+static int json_stream_token(json_stream* stream)
+{
+    const json_char* token = stream->text + stream->token_start;
+    size_t length = stream->text_length - stream->token_start;
+    json_number num;
+    json_type type;
+    json_value* value;
+
+    if (json_is_digit(*token) || *token == '-')
+    {
+        if (json_scan_number(token, token + length, &num) != json_number_ok || num.end != token + length)
+            return -1;
+
+        type = json_integer;
+    }
+    else if ((length == 4 && !memcmp(token, "true", 4)) || (length == 5 && !memcmp(token, "false", 5)))
+        type = json_boolean;
+    else if (length == 4 && !memcmp(token, "null", 4))
+        type = json_null;
+    else
+        return -1;
+
+    if (stream->previous)
+    {
+        /* update the scalar of the previous tree in place */
+        if (!json_check_limits(&stream->state, (unsigned int)stream->num_frames, type))
+            return 0;
+
+        value = json_stream_expected(stream);
+        value->type = type;
+    }
+    else if (!(value = json_stream_value(stream, type)))
+        return 0;
+
+    if (type == json_integer)
+        json_store_number(value, &num, token);
+    else
+        value->u.boolean = (*token == 't');
+
+    stream->text_length = stream->token_start;
+    return (stream->previous ? json_stream_matched(stream) : json_stream_push(stream, value));
+}
+
+/* Release everything that has not been handed out */
+static void json_stream_clear(json_stream* stream)
+{
+    json_settings* settings = &stream->state.settings;
+    size_t i;
+
+    /* while matching, the open frames are nodes of the previous tree */
+    if (stream->previous)
+    {
+        json_value_free_ex(settings, stream->previous);
+        stream->previous = 0;
+        stream->num_frames = 0;
+    }
+
+    for (i = 0; i < stream->num_children; ++i)
+        json_value_free_ex(settings, stream->children[i]);
+
+    for (i = 0; i < stream->num_entries; ++i)
+        json_value_free_ex(settings, stream->entries[i].value);
+
+    /* open containers hold no children yet */
+    for (i = 0; i < stream->num_frames; ++i)
+        settings->mem_free(stream->frames[i].value, settings->user_data);
+
+    json_value_free_ex(settings, stream->root);
+
+    stream->root = 0;
+    stream->num_frames = stream->num_children = stream->num_entries = stream->text_length = 0;
+}
+
+void json_stream_reset(json_stream* stream)
+{
+    json_stream_clear(stream);
+
+    stream->st = json_stream_st_value;
+    stream->escape = 0;
+    stream->offset = stream->line_offset = 0;
+    stream->error[0] = '\0';
+    stream->state.used_memory = 0;
+    stream->state.num_values = 0;
+    stream->state.limit_error = 0;
+    stream->state.cur_line = 1;
+    stream->state.cur_col = 0;
+}
+
+void json_stream_reuse(json_stream* stream, json_value* previous)
+{
+    json_stream_reset(stream);
+    stream->previous = previous;
+}
+
+json_stream* json_stream_new(json_settings* settings)
+{
+    json_settings defaults = json_settings();
+    json_stream* stream;
+
+    if (!settings)
+        settings = &defaults;
+
+    if (!(stream = (json_stream*)(settings->mem_alloc ? settings->mem_alloc : default_alloc)
+        (sizeof(json_stream), 1, settings->user_data)))
+    {
+        return 0;
+    }
+
+    memcpy(&stream->state.settings, settings, sizeof(json_settings));
+
+    if (!stream->state.settings.mem_alloc)
+        stream->state.settings.mem_alloc = default_alloc;
+
+    if (!stream->state.settings.mem_free)
+        stream->state.settings.mem_free = default_free;
+
+    memset(&stream->state.uint_max, 0xFF, sizeof(stream->state.uint_max));
+    memset(&stream->state.ulong_max, 0xFF, sizeof(stream->state.ulong_max));
+
+    stream->state.uint_max -= 8;
+    stream->state.ulong_max -= 8;
+
+    json_stream_reset(stream);
+    return stream;
+}
+
+void json_stream_free(json_stream* stream)
+{
+    json_settings* settings;
+
+    if (!stream)
+        return;
+
+    settings = &stream->state.settings;
+    json_stream_clear(stream);
+
+    settings->mem_free(stream->frames, settings->user_data);
+    settings->mem_free(stream->children, settings->user_data);
+    settings->mem_free(stream->entries, settings->user_data);
+    settings->mem_free(stream->text, settings->user_data);
+    settings->mem_free(stream, settings->user_data);
+}
+
+#define stream_line_and_col \
+   stream->state.cur_line, stream->state.cur_col
+
+json_stream_status json_stream_feed(json_stream* stream, const json_char* json, size_t length)
+{
+    const json_char* ptr = json, * end = json + length;
+    int result;
+
+    while (ptr < end && stream->st != json_stream_st_failed)
+    {
+        json_char b = *ptr;
+
+        stream->state.cur_col = (unsigned int)(stream->offset + (ptr - json) - stream->line_offset);
+
+        switch (stream->st)
+        {
+        case json_stream_st_string:
+
+            if (!stream->escape)
+            {
+                /* copy runs of plain characters in one go */
+                const json_char* run = ptr;
+
+                while (ptr < end && *ptr != '"' && *ptr != '\\')
+                    ++ptr;
+
+                if (ptr > run && !json_stream_text(stream, run, ptr - run))
+                    goto e_alloc_failure;
+
+                if (stream->text_length - stream->token_start > stream->state.uint_max)
+                    goto e_overflow;
+
+                if (ptr == end)
+                    continue;
+
+                if (*ptr++ == '\\')
+                {
+                    stream->escape = 1;
+                    continue;
+                }
+
+                if (!json_stream_string(stream))
+                    goto e_alloc_failure;
+
+                continue;
+            }
+
+            ++ptr;
+
+            switch (stream->escape)
+            {
+            case 1:
+
+                stream->escape = 0;
+
+                switch (b)
+                {
+                case 'b':  b = '\b';  break;
+                case 'f':  b = '\f';  break;
+                case 'n':  b = '\n';  break;
+                case 'r':  b = '\r';  break;
+                case 't':  b = '\t';  break;
+                case 'u':
+
+                    stream->escape = 2;
+                    stream->hex_digits = 0;
+                    stream->uchar = 0;
+                    stream->uchar_high = 0;
+                    continue;
+
+                default:
+                    break;
+                };
+
+                if (!json_stream_text(stream, &b, 1))
+                    goto e_alloc_failure;
+
+                continue;
+
+            case 2:
+
+                if (hex_value(b) == 0xFF)
+                {
+                    snprintf(stream->error, sizeof(stream->error), "Invalid character value `%c` (at %d:%d)", b, stream_line_and_col);
+                    goto e_failed;
+                }
+
+                stream->uchar = (stream->uchar << 4) | hex_value(b);
+
+                if (++stream->hex_digits < 4)
+                    continue;
+
+                if (!stream->uchar_high && (stream->uchar & 0xF800) == 0xD800)
+                {
+                    stream->uchar_high = stream->uchar;
+                    stream->escape = 3;
+                    continue;
+                }
+
+                if (stream->uchar_high)
+                    stream->uchar = 0x010000 | ((stream->uchar_high & 0x3FF) << 10) | (stream->uchar & 0x3FF);
+
+                stream->escape = 0;
+
+                if (!json_stream_uchar(stream, stream->uchar))
+                    goto e_alloc_failure;
+
+                continue;
+
+            default:
+
+                if (b != (stream->escape == 3 ? '\\' : 'u'))
+                {
+                    snprintf(stream->error, sizeof(stream->error), "Invalid character value `%c` (at %d:%d)", b, stream_line_and_col);
+                    goto e_failed;
+                }
+
+                if (++stream->escape > 4)
+                {
+                    stream->escape = 2;
+                    stream->hex_digits = 0;
+                    stream->uchar = 0;
+                }
+
+                continue;
+            };
+
+        case json_stream_st_token:
+
+            if (json_is_digit(b) || (b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z') || b == '+' || b == '-' || b == '.')
+            {
+                if (!json_stream_text(stream, &b, 1))
+                    goto e_alloc_failure;
+
+                ++ptr;
+                continue;
+            }
+
+            /* the delimiter is processed in the next state */
+            if ((result = json_stream_token(stream)) < 0)
+                goto e_unknown_value;
+
+            if (!result)
+                goto e_alloc_failure;
+
+            continue;
+
+        default:
+            break;
+        };
+
+        ++ptr;
+
+        switch (b)
+        {
+        case '\n':
+
+            ++stream->state.cur_line;
+            stream->line_offset = stream->offset + (ptr - json);
+            /* fall through */
+
+        case ' ': case '\t': case '\r':
+            continue;
+
+        default:
+            break;
+        };
+
+        switch (stream->st)
+        {
+        case json_stream_st_first_value:
+
+            if (b == ']')
+            {
+                if (!json_stream_close(stream))
+                    goto e_alloc_failure;
+
+                continue;
+            }
+            /* fall through */
+
+
+        case json_stream_st_value:
+
+            switch (b)
+            {
+            case '{':
+
+                if (!json_stream_open(stream, json_object))
+                    goto e_alloc_failure;
+
+                continue;
+
+            case '[':
+
+                if (!json_stream_open(stream, json_array))
+                    goto e_alloc_failure;
+
+                continue;
+
+            case '"':
+
+                if (!json_stream_expect(stream, json_string))
+                    goto e_alloc_failure;
+
+                stream->st = json_stream_st_string;
+                stream->token_start = stream->text_length;
+                stream->token_is_name = 0;
+                continue;
+
+            default:
+
+                if (json_is_digit(b) || b == '-' || (b >= 'a' && b <= 'z'))
+                {
+                    if (!json_stream_expect(stream, json_null))
+                        goto e_alloc_failure;
+
+                    stream->st = json_stream_st_token;
+                    stream->token_start = stream->text_length;
+
+                    if (!json_stream_text(stream, &b, 1))
+                        goto e_alloc_failure;
+
+                    continue;
+                }
+
+                /* skip a UTF-8 byte order mark */
+                if (!stream->num_frames && stream->offset + (ptr - json) <= 3
+                    && (unsigned char)b == (unsigned char)"\xEF\xBB\xBF"[stream->offset + (ptr - json) - 1])
+                {
+                    continue;
+                }
+
+                snprintf(stream->error, sizeof(stream->error), "%d:%d: Unexpected %c when seeking value", stream_line_and_col, b);
+                goto e_failed;
+            };
+
+        case json_stream_st_first_name:
+
+            if (b == '}')
+            {
+                if (!json_stream_close(stream))
+                    goto e_alloc_failure;
+
+                continue;
+            }
+            /* fall through */
+
+
+        case json_stream_st_name:
+
+            if (b == '"')
+            {
+                /* a name beyond the entries of the previous tree */
+                if (stream->previous && !json_stream_expected(stream) && !json_stream_diverge(stream))
+                    goto e_alloc_failure;
+
+                stream->st = json_stream_st_string;
+                stream->token_start = stream->text_length;
+                stream->token_is_name = 1;
+                continue;
+            }
+
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: Unexpected `%c` in object", stream_line_and_col, b);
+            goto e_failed;
+
+        case json_stream_st_colon:
+
+            if (b == ':')
+            {
+                stream->st = json_stream_st_value;
+                continue;
+            }
+
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: Expected : before %c", stream_line_and_col, b);
+            goto e_failed;
+
+        case json_stream_st_next:
+
+            /* a trailing comma is tolerated, as by json_parse_ex */
+            if (b == ',')
+            {
+                stream->st = (stream->frames[stream->num_frames - 1].value->type == json_array
+                    ? json_stream_st_first_value : json_stream_st_first_name);
+                continue;
+            }
+
+            if (b == (stream->frames[stream->num_frames - 1].value->type == json_array ? ']' : '}'))
+            {
+                if (!json_stream_close(stream))
+                    goto e_alloc_failure;
+
+                continue;
+            }
+
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: Expected , before %c", stream_line_and_col, b);
+            goto e_failed;
+
+        case json_stream_st_done:
+
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: Trailing garbage: `%c`", stream_line_and_col, b);
+            goto e_failed;
+
+        default:
+            break;
+        };
+    }
+
+    stream->offset += (ptr - json);
+
+    return (stream->st == json_stream_st_done ? json_stream_complete
+        : stream->st == json_stream_st_failed ? json_stream_failed : json_stream_more);
+
+e_unknown_value:
+
+    snprintf(stream->error, sizeof(stream->error), "%d:%d: Unknown value", stream_line_and_col);
+    goto e_failed;
+
+e_alloc_failure:
+
+    if (stream->state.limit_error)
+        snprintf(stream->error, sizeof(stream->error), "%d:%d: %s", stream_line_and_col, stream->state.limit_error);
+    else
+        strncpy(stream->error, "Memory allocation failure", sizeof(stream->error));
+    goto e_failed;
+
+e_overflow:
+
+    snprintf(stream->error, sizeof(stream->error), "%d:%d: Too long (caught overflow)", stream_line_and_col);
+    goto e_failed;
+
+e_failed:
+
+    json_stream_clear(stream);
+    stream->st = json_stream_st_failed;
+    return json_stream_failed;
+}
+
+json_value* json_stream_finish(json_stream* stream, char* error_buf)
+{
+    json_value* root;
+    int result;
+
+    /* a number or literal as root value ends with the input */
+    if (stream->st == json_stream_st_token && !stream->num_frames)
+    {
+        if ((result = json_stream_token(stream)) < 0)
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: Unknown value", stream_line_and_col);
+        else if (!result && stream->state.limit_error)
+            snprintf(stream->error, sizeof(stream->error), "%d:%d: %s", stream_line_and_col, stream->state.limit_error);
+        else if (!result)
+            strncpy(stream->error, "Memory allocation failure", sizeof(stream->error));
+
+    }
+
+    if (stream->st != json_stream_st_done)
+    {
+        if (error_buf)
+        {
+            if (*stream->error)
+                strcpy(error_buf, stream->error);
+            else
+                snprintf(error_buf, json_error_max, "%d:%d: Unexpected EOF", stream_line_and_col);
+        }
+
+        json_stream_reset(stream);
+        return 0;
+    }
+
+    root = stream->root;
+    stream->root = 0;
+    json_stream_reset(stream);
+
+    if (stream->state.settings.settings & json_index_objects)
+        json_object_index_ex(&stream->state.settings, root);
+
+    return root;
 }
@@ -0,0 +1,221 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <JsonBatch.hpp>
+#include <cstdio>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Constructor; the batch is empty.
+ * @param _intern_paths true to intern all key paths in the global PathInterner; otherwise only key paths that have been
+ *                      interned already get their global id, and all others get a batch-local id
+ */
+JsonBatch::JsonBatch(const bool _intern_paths) : intern_paths(_intern_paths) {}
+
+
+/**
+ * Flatten all leaves of the given json tree and append them as rows to this batch.
+ * Leaves are appended in json document order; array elements are addressed by their index, e.g. "Status:FriendlyName:0".
+ * Empty objects and empty arrays do not produce rows.
+ * @param json the json tree
+ * @param device_id the device id to store in each appended row
+ * @return the number of rows that have been appended
+ */
+size_t JsonBatch::flatten(const json_value* const json, const uint32_t device_id) {
+    const size_t num_rows = size();
+    if (json != NULL && json->type != json_none) {
+        path_buffer.clear();
+        traverse(json, device_id);
+    }
+    return size() - num_rows;
+}
+
+
+/**
+ * Remove all rows from this batch. The capacity of all columns is kept. Batch-local path ids are forgotten, so that key paths
+ * interned since then get their global id in the next rows.
+ */
+void JsonBatch::clear(void) {
+    device_ids.clear();
+    path_ids.clear();
+    types.clear();
+    integers.clear();
+    doubles.clear();
+    string_offsets.clear();
+    string_lengths.clear();
+    string_buffer.clear();
+    local_paths.clear();
+    local_ids.clear();
+}
+
+
+/**
+ * Get the key path of the given path id.
+ * @param path_id a global or batch-local path id
+ * @return the key path
+ */
+const std::string& JsonBatch::getPath(const PathInterner::PathId path_id) const {
+    if ((path_id & LOCAL_PATH) != 0 && path_id != PathInterner::INVALID_ID) {
+        static const std::string empty;
+        const size_t index = path_id & ~LOCAL_PATH;
+        return (index < local_paths.size() ? local_paths[index] : empty);
+    }
+    return PathInterner::instance().getPath(path_id);
+}
+
+
+/**
+ * Get the path id of the given key path, as used in the path id column.
+ * @param path the key path
+ * @return the global or batch-local path id, or PathInterner::INVALID_ID if no row of this batch has used the key path
+ *         and it has not been interned
+ */
+PathInterner::PathId JsonBatch::findPath(const std::string& path) const {
+    std::unordered_map<std::string, PathInterner::PathId>::const_iterator it = local_ids.find(path);
+    return (it != local_ids.end() ? it->second : PathInterner::instance().find(path));
+}
+
+
+/**
+ * Get the string value of the given row.
+ * @param row the row
+ * @return a view into the string buffer; it is empty if the row does not hold a string
+ */
+JsonCpp::StringView JsonBatch::getString(const size_t row) const {
+    if (row >= size() || types[row] != VALUE_STRING) {
+        return JsonCpp::StringView();
+    }
+    return JsonCpp::StringView(string_buffer.data() + string_offsets[row], string_lengths[row]);
+}
+
+
+/**
+ * Recursively traverse the json tree and append a row for each leaf. The key path of value is held in path_buffer.
+ */
+void JsonBatch::traverse(const json_value* const value, const uint32_t device_id) {
+    const size_t path_length = path_buffer.length();
+    switch (value->type) {
+    case json_object:
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            const json_object_entry& entry = value->u.object.values[i];
+            if (path_length > 0) {
+                path_buffer.append(1, ':');
+            }
+            path_buffer.append(entry.name, entry.name_length);
+            traverse(entry.value, device_id);
+            path_buffer.resize(path_length);
+        }
+        break;
+    case json_array:
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            char buffer[16];
+            snprintf(buffer, sizeof(buffer), (path_length > 0 ? ":%u" : "%u"), i);
+            path_buffer.append(buffer);
+            traverse(value->u.array.values[i], device_id);
+            path_buffer.resize(path_length);
+        }
+        break;
+    default:
+        appendRow(value, device_id);
+        break;
+    }
+}
+
+
+/**
+ * Get the path id for the key path of a new row: its batch-local id if a previous row got one, so that a key path keeps its id
+ * until the batch is cleared, otherwise its global id if it is interned, or a new batch-local id.
+ * The lookups do not create a string once the key path is known.
+ */
+PathInterner::PathId JsonBatch::getPathId(const std::string& path) {
+    if (intern_paths == true) {
+        return PathInterner::instance().intern(path);
+    }
+    std::unordered_map<std::string, PathInterner::PathId>::const_iterator it = local_ids.find(path);
+    if (it != local_ids.end()) {
+        return it->second;
+    }
+    PathInterner::PathId path_id = PathInterner::instance().find(path);
+    if (path_id != PathInterner::INVALID_ID) {
+        return path_id;
+    }
+    path_id = (PathInterner::PathId)local_paths.size() | LOCAL_PATH;
+    local_paths.push_back(path);
+    local_ids[path] = path_id;
+    return path_id;
+}
+
+
+/**
+ * Append a row for the given leaf value. The key path of the leaf is held in path_buffer.
+ */
+void JsonBatch::appendRow(const json_value* const value, const uint32_t device_id) {
+    int64_t  integer = 0;
+    double   dbl = 0.0;
+    uint32_t string_offset = 0, string_length = 0;
+    uint8_t  type = VALUE_NULL;
+
+    switch (value->type) {
+    case json_boolean:
+        type = VALUE_BOOLEAN;
+        integer = (value->u.boolean != 0 ? 1 : 0);
+        break;
+    case json_integer:
+        type = VALUE_INTEGER;
+        integer = value->u.integer;
+        break;
+    case json_double:
+        type = VALUE_DOUBLE;
+        dbl = value->u.dbl;
+        break;
+    case json_string:
+        type = VALUE_STRING;
+        string_offset = (uint32_t)string_buffer.length();
+        string_length = value->u.string.length;
+        string_buffer.append(value->u.string.ptr, value->u.string.length);
+        break;
+    default:
+        break;
+    }
+
+    device_ids.push_back(device_id);
+    path_ids.push_back(getPathId(path_buffer));
+    types.push_back(type);
+    integers.push_back(integer);
+    doubles.push_back(dbl);
+    string_offsets.push_back(string_offset);
+    string_lengths.push_back(string_length);
+}
+
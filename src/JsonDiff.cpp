@@ -0,0 +1,230 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <JsonDiff.hpp>
+#include <cstdio>
+#include <cstring>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Compare two json trees and collect all changed leaves in a single simultaneous walk.
+ * A NULL tree is treated as empty, i.e. all leaves of the other tree are reported as added or removed.
+ * @param old_tree the old json tree, or NULL
+ * @param new_tree the new json tree, or NULL
+ * @param changes output - the changes are appended to this vector; the change values point into the given json trees
+ * @return the number of changes that have been appended
+ */
+size_t JsonDiff::diff(const json_value* const old_tree, const json_value* const new_tree, ChangeVector& changes) {
+    size_t num_changes = changes.size();
+    std::string path;
+    path.reserve(64);
+    if (old_tree == NULL) {
+        report(CHANGE_ADDED, new_tree, path, changes);
+    }
+    else if (new_tree == NULL) {
+        report(CHANGE_REMOVED, old_tree, path, changes);
+    }
+    else {
+        compare(old_tree, new_tree, path, changes);
+    }
+    return changes.size() - num_changes;
+}
+
+
+/**
+ * Compare two json leaf values. Integer and double values are compared numerically; containers are never equal.
+ * @param value1 the first json value
+ * @param value2 the second json value
+ * @return true, if both values are equal
+ */
+bool JsonDiff::equalValues(const json_value* const value1, const json_value* const value2) {
+    if (value1->type != value2->type) {
+        if (value1->type == json_integer && value2->type == json_double) {
+            return (double)value1->u.integer == value2->u.dbl;
+        }
+        if (value1->type == json_double && value2->type == json_integer) {
+            return value1->u.dbl == (double)value2->u.integer;
+        }
+        return false;
+    }
+    switch (value1->type) {
+    case json_integer: return value1->u.integer == value2->u.integer;
+    case json_double:  return value1->u.dbl == value2->u.dbl;
+    case json_boolean: return (value1->u.boolean != 0) == (value2->u.boolean != 0);
+    case json_string:  return value1->u.string.length == value2->u.string.length &&
+                              memcmp(value1->u.string.ptr, value2->u.string.ptr, value1->u.string.length) == 0;
+    case json_null:    return true;
+    default:           break;
+    }
+    return false;
+}
+
+
+/**
+ * Recursively compare two json values.
+ * @param old_value the json value in the old tree
+ * @param new_value the json value in the new tree
+ * @param path the key path of both values
+ * @param changes output - the changes are appended to this vector
+ */
+void JsonDiff::compare(const json_value* const old_value, const json_value* const new_value, std::string& path, ChangeVector& changes) {
+    const size_t path_length = path.length();
+
+    if (old_value->type == json_object && new_value->type == json_object) {
+        const unsigned int old_length = old_value->u.object.length;
+        const unsigned int new_length = new_value->u.object.length;
+        bool aligned = (old_length == new_length);
+
+        for (unsigned int i = 0; i < new_length; ++i) {
+            const json_object_entry& new_entry = new_value->u.object.values[i];
+            const json_object_entry* old_entry = NULL;
+
+            // try the entry at the same position first, and fall back to a lookup by name
+            if (i < old_length && old_value->u.object.values[i].name_length == new_entry.name_length &&
+                memcmp(old_value->u.object.values[i].name, new_entry.name, new_entry.name_length) == 0) {
+                old_entry = &old_value->u.object.values[i];
+            }
+            else {
+                aligned = false;
+                old_entry = json_object_find(old_value, new_entry.name, new_entry.name_length, json_match_exact);
+            }
+
+            appendName(path, new_entry.name, new_entry.name_length);
+            if (old_entry != NULL) {
+                compare(old_entry->value, new_entry.value, path, changes);
+            }
+            else {
+                report(CHANGE_ADDED, new_entry.value, path, changes);
+            }
+            path.resize(path_length);
+        }
+
+        // if entries were not aligned by position, report entries missing in the new tree
+        if (aligned == false) {
+            for (unsigned int i = 0; i < old_length; ++i) {
+                const json_object_entry& old_entry = old_value->u.object.values[i];
+                if (json_object_find(new_value, old_entry.name, old_entry.name_length, json_match_exact) == NULL) {
+                    appendName(path, old_entry.name, old_entry.name_length);
+                    report(CHANGE_REMOVED, old_entry.value, path, changes);
+                    path.resize(path_length);
+                }
+            }
+        }
+        return;
+    }
+
+    if (old_value->type == json_array && new_value->type == json_array) {
+        const unsigned int old_length = old_value->u.array.length;
+        const unsigned int new_length = new_value->u.array.length;
+        const unsigned int length = (old_length > new_length ? old_length : new_length);
+
+        for (unsigned int i = 0; i < length; ++i) {
+            appendIndex(path, i);
+            if (i >= old_length) {
+                report(CHANGE_ADDED, new_value->u.array.values[i], path, changes);
+            }
+            else if (i >= new_length) {
+                report(CHANGE_REMOVED, old_value->u.array.values[i], path, changes);
+            }
+            else {
+                compare(old_value->u.array.values[i], new_value->u.array.values[i], path, changes);
+            }
+            path.resize(path_length);
+        }
+        return;
+    }
+
+    if (equalValues(old_value, new_value) == false) {
+        changes.push_back(Change(CHANGE_MODIFIED, path, old_value, new_value));
+    }
+}
+
+
+/**
+ * Report all leaves of the given json value as added or removed.
+ * @param type CHANGE_ADDED or CHANGE_REMOVED
+ * @param value the json value
+ * @param path the key path of the json value
+ * @param changes output - the changes are appended to this vector
+ */
+void JsonDiff::report(const ChangeType type, const json_value* const value, std::string& path, ChangeVector& changes) {
+    if (value == NULL) {
+        return;
+    }
+    const size_t path_length = path.length();
+    switch (value->type) {
+    case json_object:
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            appendName(path, value->u.object.values[i].name, value->u.object.values[i].name_length);
+            report(type, value->u.object.values[i].value, path, changes);
+            path.resize(path_length);
+        }
+        break;
+    case json_array:
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            appendIndex(path, i);
+            report(type, value->u.array.values[i], path, changes);
+            path.resize(path_length);
+        }
+        break;
+    default:
+        changes.push_back(Change(type, path, (type == CHANGE_REMOVED ? value : NULL), (type == CHANGE_ADDED ? value : NULL)));
+        break;
+    }
+}
+
+
+/**
+ * Append an object entry name to the given key path.
+ */
+void JsonDiff::appendName(std::string& path, const json_char* name, const unsigned int name_length) {
+    if (path.length() > 0) {
+        path.append(1, ':');
+    }
+    path.append(name, name_length);
+}
+
+
+/**
+ * Append an array index to the given key path.
+ */
+void JsonDiff::appendIndex(std::string& path, const unsigned int index) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u", index);
+    if (path.length() > 0) {
+        path.append(1, ':');
+    }
+    path.append(buffer);
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <JsonWriter.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <clocale>
+#include <cfloat>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Constructor.
+ * @param _buffer the buffer the json text is appended to; it must outlive the writer
+ */
+JsonWriter::JsonWriter(std::string& _buffer) :
+    buffer(_buffer),
+    need_comma(false),
+    after_key(false)
+{}
+
+
+/**
+ * Begin a json object.
+ */
+JsonWriter& JsonWriter::beginObject(void) {
+    separate();
+    buffer.append(1, '{');
+    need_comma = false;
+    return *this;
+}
+
+/**
+ * End a json object.
+ */
+JsonWriter& JsonWriter::endObject(void) {
+    buffer.append(1, '}');
+    need_comma = true;
+    return *this;
+}
+
+/**
+ * Begin a json array.
+ */
+JsonWriter& JsonWriter::beginArray(void) {
+    separate();
+    buffer.append(1, '[');
+    need_comma = false;
+    return *this;
+}
+
+/**
+ * End a json array.
+ */
+JsonWriter& JsonWriter::endArray(void) {
+    buffer.append(1, ']');
+    need_comma = true;
+    return *this;
+}
+
+
+/**
+ * Write an object key; it must be followed by a value.
+ * @param key pointer to the key characters
+ * @param length number of key characters
+ */
+JsonWriter& JsonWriter::writeKey(const char* key, const size_t length) {
+    if (need_comma) {
+        buffer.append(1, ',');
+    }
+    buffer.append(1, '"');
+    appendEscaped(buffer, key, length);
+    buffer.append("\":", 2);
+    need_comma = false;
+    after_key = true;
+    return *this;
+}
+
+/**
+ * Write an object key; it must be followed by a value.
+ * @param key null terminated key
+ */
+JsonWriter& JsonWriter::writeKey(const char* key) {
+    return writeKey(key, strlen(key));
+}
+
+
+/**
+ * Write a string value; the characters are escaped as needed.
+ * @param value pointer to the string characters
+ * @param length number of string characters
+ */
+JsonWriter& JsonWriter::writeString(const char* value, const size_t length) {
+    separate();
+    buffer.append(1, '"');
+    appendEscaped(buffer, value, length);
+    buffer.append(1, '"');
+    return *this;
+}
+
+/**
+ * Write a string value; the characters are escaped as needed.
+ * @param value null terminated string
+ */
+JsonWriter& JsonWriter::writeString(const char* value) {
+    return writeString(value, strlen(value));
+}
+
+
+/**
+ * Write an integer value.
+ */
+JsonWriter& JsonWriter::writeInteger(const int64_t value) {
+    separate();
+    appendInteger(buffer, value);
+    return *this;
+}
+
+/**
+ * Write a double value; values that are not finite are written as null.
+ */
+JsonWriter& JsonWriter::writeDouble(const double value) {
+    separate();
+    appendDouble(buffer, value);
+    return *this;
+}
+
+/**
+ * Write a boolean value.
+ */
+JsonWriter& JsonWriter::writeBool(const bool value) {
+    separate();
+    if (value) {
+        buffer.append("true", 4);
+    }
+    else {
+        buffer.append("false", 5);
+    }
+    return *this;
+}
+
+/**
+ * Write a null value.
+ */
+JsonWriter& JsonWriter::writeNull(void) {
+    separate();
+    buffer.append("null", 4);
+    return *this;
+}
+
+
+/**
+ * Write a json tree, e.g. a parsed response, as a value.
+ * @param value the json tree; NULL or json_none are written as null
+ */
+JsonWriter& JsonWriter::writeJson(const json_value* const value) {
+    if (value == NULL) {
+        return writeNull();
+    }
+    switch (value->type) {
+    case json_object:
+        beginObject();
+        for (unsigned int i = 0; i < value->u.object.length; ++i) {
+            writeKey(value->u.object.values[i].name, value->u.object.values[i].name_length);
+            writeJson(value->u.object.values[i].value);
+        }
+        return endObject();
+    case json_array:
+        beginArray();
+        for (unsigned int i = 0; i < value->u.array.length; ++i) {
+            writeJson(value->u.array.values[i]);
+        }
+        return endArray();
+    case json_integer:
+        return writeInteger(value->u.integer);
+    case json_double:
+        return writeDouble(value->u.dbl);
+    case json_string:
+        return writeString(value->u.string.ptr, value->u.string.length);
+    case json_boolean:
+        return writeBool(value->u.boolean != 0);
+    default:
+        return writeNull();
+    }
+}
+
+
+/**
+ * Insert a comma before the next value, unless it is the first value at the current nesting level or the value of a key.
+ */
+void JsonWriter::separate(void) {
+    if (after_key) {
+        after_key = false;
+    }
+    else if (need_comma) {
+        buffer.append(1, ',');
+    }
+    need_comma = true;
+}
+
+
+/**
+ * Append the decimal representation of an integer. Digits are produced in pairs from a lookup table.
+ * @param buffer the buffer to append to
+ * @param value the integer value
+ */
+void JsonWriter::appendInteger(std::string& buffer, const int64_t value) {
+    static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    char text[24];
+    char* ptr = text + sizeof(text);
+    uint64_t magnitude = (value < 0 ? 0 - (uint64_t)value : (uint64_t)value);
+    while (magnitude >= 100) {
+        const unsigned int pair = (unsigned int)(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--ptr = digit_pairs[pair + 1];
+        *--ptr = digit_pairs[pair];
+    }
+    if (magnitude >= 10) {
+        const unsigned int pair = (unsigned int)magnitude * 2;
+        *--ptr = digit_pairs[pair + 1];
+        *--ptr = digit_pairs[pair];
+    }
+    else {
+        *--ptr = (char)('0' + magnitude);
+    }
+    if (value < 0) {
+        *--ptr = '-';
+    }
+    buffer.append(ptr, text + sizeof(text) - ptr);
+}
+
+
+/**
+ * Append the shortest decimal representation of a double that parses back to the same value.
+ * Sensor readings usually have a few decimal places only; they are formatted as scaled integers.
+ * Other values fall back to printf formatting, with a '.' decimal point in any locale. Values that are not finite are appended as null.
+ * @param buffer the buffer to append to
+ * @param value the double value
+ */
+void JsonWriter::appendDouble(std::string& buffer, const double value) {
+    static const double powers_of_10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+
+    if (value != value || value - value != 0) {
+        buffer.append("null", 4);
+        return;
+    }
+
+    // try value = integer / 10^decimals with up to 6 decimals; the integer part must be exact in a double
+    if (value > -1e9 && value < 1e9) {
+        for (unsigned int decimals = 0; decimals < sizeof(powers_of_10) / sizeof(powers_of_10[0]); ++decimals) {
+            const double scaled = value * powers_of_10[decimals];
+            const int64_t integer = (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+            if ((double)integer / powers_of_10[decimals] != value) {
+                continue;
+            }
+            const size_t offset = buffer.length();
+            appendInteger(buffer, integer < 0 ? -integer : integer);
+            if (decimals > 0) {
+                size_t num_digits = buffer.length() - offset;
+                if (num_digits <= decimals) {
+                    buffer.insert(offset, decimals + 1 - num_digits, '0');
+                    num_digits = decimals + 1;
+                }
+                buffer.insert(offset + num_digits - decimals, 1, '.');
+            }
+            if (integer < 0) {
+                buffer.insert(offset, 1, '-');
+            }
+            else if (integer == 0 && 1 / value < 0) {
+                buffer.insert(offset, 1, '-');
+                if (decimals == 0) {
+                    buffer.append(".0", 2);     // "-0" would parse as the integer 0 and lose the sign
+                }
+            }
+            return;
+        }
+    }
+
+    // general case: use the fewest significant digits that are exact; %g drops trailing zeros, so normal values with fewer than
+    // 15 digits are exact with 15 already, while subnormal values have less precision and may need fewer. snprintf() and strtod()
+    // both use the decimal point of the current locale, e.g. a decimal comma, so it is replaced by '.' afterwards
+    char text[32];
+    for (int precision = (value > -DBL_MIN && value < DBL_MIN ? 1 : 15); precision <= 17; ++precision) {
+        snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (strtod(text, NULL) == value) {
+            break;
+        }
+    }
+    const char* const point = localeconv()->decimal_point;
+    if (point != NULL && point[0] != '\0' && strcmp(point, ".") != 0) {
+        char* const found = strstr(text, point);
+        if (found != NULL) {
+            const size_t point_length = strlen(point);
+            *found = '.';
+            memmove(found + 1, found + point_length, strlen(found + point_length) + 1);
+        }
+    }
+    buffer.append(text);
+}
+
+
+/**
+ * Append a string with json escaping; runs of characters that need no escaping are appended in bulk.
+ * @param buffer the buffer to append to
+ * @param value pointer to the string characters
+ * @param length number of string characters
+ */
+void JsonWriter::appendEscaped(std::string& buffer, const char* value, const size_t length) {
+    static const char hex_digits[] = "0123456789abcdef";
+
+    size_t run = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char c = (unsigned char)value[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer.append(value + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"':  buffer.append("\\\"", 2); break;
+        case '\\': buffer.append("\\\\", 2); break;
+        case '\b': buffer.append("\\b", 2);  break;
+        case '\f': buffer.append("\\f", 2);  break;
+        case '\n': buffer.append("\\n", 2);  break;
+        case '\r': buffer.append("\\r", 2);  break;
+        case '\t': buffer.append("\\t", 2);  break;
+        default: {
+            const char escape[6] = { '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0xf] };
+            buffer.append(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    buffer.append(value + run, length - run);
+}
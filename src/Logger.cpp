@@ -21,7 +21,7 @@ Logger::ListenerEntry* Logger::s_listener = NULL;
  */
 Logger::Logger(const char* moduleName) : m_module_name(moduleName) {
     m_module_name_w.resize(m_module_name.length());
-    for (int i = 0; i < m_module_name.length(); ++i) {
+    for (size_t i = 0; i < m_module_name.length(); ++i) {
         m_module_name_w[i] = m_module_name[i];
     }
 }
@@ -0,0 +1,213 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <PathInterner.hpp>
+#include <cstring>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Get the process wide interner instance.
+ */
+PathInterner& PathInterner::instance(void) {
+    static PathInterner interner;
+    return interner;
+}
+
+
+/**
+ * Constructor; the interner is empty.
+ */
+PathInterner::PathInterner(void) :
+    count(0),
+    table(newTable(256))
+{
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i] = NULL;
+    }
+}
+
+
+/**
+ * Destructor; releases all entries and hash tables.
+ */
+PathInterner::~PathInterner(void) {
+    const uint32_t num_entries = count.load(std::memory_order_acquire);
+    for (uint32_t id = 0; id < num_entries; ++id) {
+        delete chunks[id >> CHUNK_BITS][id & ((1u << CHUNK_BITS) - 1)].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+        delete[] chunks[i];
+    }
+    retired_tables.push_back(table.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < retired_tables.size(); ++i) {
+        delete[] retired_tables[i]->slots;
+        delete retired_tables[i];
+    }
+}
+
+
+/**
+ * Intern the given key path. If the path is already interned, this is a lock-free lookup.
+ * @param path pointer to the key path characters
+ * @param length number of key path characters
+ * @return the id of the key path, or INVALID_ID if the interner is full
+ */
+PathInterner::PathId PathInterner::intern(const char* path, const size_t length) {
+    const uint32_t hash = hashPath(path, length);
+    PathId id = lookup(table.load(std::memory_order_acquire), path, length, hash);
+    if (id != INVALID_ID) {
+        return id;
+    }
+
+    std::lock_guard<std::mutex> lock(insert_mutex);
+
+    // another thread may have interned the path in the meantime
+    Table* tab = table.load(std::memory_order_relaxed);
+    id = lookup(tab, path, length, hash);
+    if (id != INVALID_ID) {
+        return id;
+    }
+    id = count.load(std::memory_order_relaxed);
+    if ((id >> CHUNK_BITS) >= MAX_CHUNKS) {
+        return INVALID_ID;
+    }
+
+    // publish the entry before its id can be found in the hash table
+    std::atomic<Entry*>*& chunk = chunks[id >> CHUNK_BITS];
+    if (chunk == NULL) {
+        chunk = new std::atomic<Entry*>[(size_t)1 << CHUNK_BITS];
+    }
+    Entry* entry = new Entry();
+    entry->hash = hash;
+    entry->path.assign(path, length);
+    chunk[id & ((1u << CHUNK_BITS) - 1)].store(entry, std::memory_order_release);
+    count.store(id + 1, std::memory_order_release);
+
+    // keep the load factor below 1/2; readers of the replaced table fall back to this locked path
+    if (2 * ((size_t)id + 1) > tab->mask + 1) {
+        Table* larger = newTable(2 * (tab->mask + 1));
+        for (PathId i = 0; i < id; ++i) {
+            insertSlot(larger, chunks[i >> CHUNK_BITS][i & ((1u << CHUNK_BITS) - 1)].load(std::memory_order_relaxed)->hash, i);
+        }
+        insertSlot(larger, hash, id);
+        table.store(larger, std::memory_order_release);
+        retired_tables.push_back(tab);
+    }
+    else {
+        insertSlot(tab, hash, id);
+    }
+    return id;
+}
+
+
+/**
+ * Get the id of the given key path without interning it; this is lock-free.
+ * @param path pointer to the key path characters
+ * @param length number of key path characters
+ * @return the id of the key path, or INVALID_ID if it is not interned
+ */
+PathInterner::PathId PathInterner::find(const char* path, const size_t length) const {
+    return lookup(table.load(std::memory_order_acquire), path, length, hashPath(path, length));
+}
+
+
+/**
+ * Get the key path of the given id; this is lock-free.
+ * @param id the id of an interned key path
+ * @return the key path, or an empty string if the id is not valid
+ */
+const std::string& PathInterner::getPath(const PathId id) const {
+    static const std::string empty;
+    if (id >= count.load(std::memory_order_acquire)) {
+        return empty;
+    }
+    return chunks[id >> CHUNK_BITS][id & ((1u << CHUNK_BITS) - 1)].load(std::memory_order_acquire)->path;
+}
+
+
+/**
+ * Probe the given hash table for the given key path.
+ */
+PathInterner::PathId PathInterner::lookup(const Table* const tab, const char* path, const size_t length, const uint32_t hash) const {
+    for (size_t index = hash & tab->mask; ; index = (index + 1) & tab->mask) {
+        const uint32_t slot = tab->slots[index].load(std::memory_order_acquire);
+        if (slot == 0) {
+            return INVALID_ID;
+        }
+        const PathId id = slot - 1;
+        const Entry* entry = chunks[id >> CHUNK_BITS][id & ((1u << CHUNK_BITS) - 1)].load(std::memory_order_acquire);
+        if (entry->hash == hash && entry->path.length() == length && memcmp(entry->path.data(), path, length) == 0) {
+            return id;
+        }
+    }
+}
+
+
+/**
+ * Allocate an empty hash table; the capacity must be a power of 2.
+ */
+PathInterner::Table* PathInterner::newTable(const size_t capacity) {
+    Table* tab = new Table();
+    tab->mask  = capacity - 1;
+    tab->slots = new std::atomic<uint32_t>[capacity];
+    for (size_t i = 0; i < capacity; ++i) {
+        tab->slots[i].store(0, std::memory_order_relaxed);
+    }
+    return tab;
+}
+
+
+/**
+ * Insert the given id into the first free slot of its probe sequence.
+ */
+void PathInterner::insertSlot(Table* const tab, const uint32_t hash, const PathId id) {
+    size_t index = hash & tab->mask;
+    while (tab->slots[index].load(std::memory_order_relaxed) != 0) {
+        index = (index + 1) & tab->mask;
+    }
+    tab->slots[index].store(id + 1, std::memory_order_release);
+}
+
+
+/**
+ * Compute the FNV-1a hash of the given key path.
+ */
+uint32_t PathInterner::hashPath(const char* path, const size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    }
+    return hash;
+}
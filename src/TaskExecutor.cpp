@@ -0,0 +1,283 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <TaskExecutor.hpp>
+#include <cstdint>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+// executor and worker index of the current thread, if it is a worker thread
+static thread_local const TaskExecutor* current_executor = NULL;
+static thread_local size_t              current_index = 0;
+static thread_local uint32_t            steal_seed = 0;
+
+
+/**
+ * Constructor; the worker threads are started.
+ * @param num_workers the number of worker threads; 0 to use the number of cpu cores
+ */
+TaskExecutor::TaskExecutor(const size_t num_workers) :
+    pending(0),
+    sleepers(0),
+    next_worker(0),
+    stopping(false)
+{
+    size_t n = (num_workers > 0 ? num_workers : std::thread::hardware_concurrency());
+    if (n == 0) {
+        n = 1;
+    }
+    workers.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        workers[i]->thread = std::thread(&TaskExecutor::run, this, i);
+    }
+}
+
+
+/**
+ * Destructor; running tasks are completed, tasks that have not started are discarded.
+ * The executor must not be destroyed by one of its own worker threads, e.g. from a task, as a thread cannot join itself.
+ */
+TaskExecutor::~TaskExecutor(void) {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+        sleep_cv.notify_all();
+    }
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+
+/**
+ * Submit a task for execution by a worker thread.
+ * @param task the task
+ */
+void TaskExecutor::submit(const Task& task) {
+    size_t index;
+    if (getWorkerIndex(index) == false) {
+        index = next_worker.fetch_add(1) % workers.size();
+    }
+    push(index, task);
+}
+
+
+/**
+ * Execute a loop body for the indices 0 up to count - 1 in parallel and wait until all indices are done.
+ * The calling thread takes part in the loop; indices are handed out one at a time, so that slow device requests do not hold
+ * up other indices. Helper tasks only take part once a worker thread starts them; if all workers are busy, the calling thread
+ * executes all indices itself and returns without waiting for the queued helper tasks, which then find no index left and
+ * return at once. The calling thread only waits for helper tasks that are executing indices; as it does not execute other
+ * tasks meanwhile, nested loops from within loop bodies are allowed.
+ * @param count the number of indices
+ * @param body the loop body; it is invoked concurrently with different indices, e.g. to store results[index]
+ * @param max_concurrency the max number of concurrent invocations of the loop body; 0 to use the number of worker threads
+ */
+void TaskExecutor::parallelFor(const size_t count, const std::function<void(const size_t index)>& body, const size_t max_concurrency) {
+    if (count == 0) {
+        return;
+    }
+    size_t concurrency = (max_concurrency > 0 ? max_concurrency : workers.size());
+    if (concurrency > count) {
+        concurrency = count;
+    }
+
+    // shared loop state; helper tasks may start after the loop has returned, they must not touch the loop body then
+    struct Loop {
+        std::atomic<size_t>     next;
+        std::atomic<size_t>     active;     // number of helper tasks that have started and may still claim indices
+        std::mutex              mutex;
+        std::condition_variable done;
+        Loop(void) : next(0), active(0) {}
+    };
+    std::shared_ptr<Loop> loop(new Loop());
+    const std::function<void(const size_t)>* loop_body = &body;
+    for (size_t i = 1; i < concurrency; ++i) {
+        submit([loop, loop_body, count]() {
+            // count this helper before claiming an index, so that the calling thread waits for each claimed index
+            ++loop->active;
+            for (size_t index = loop->next++; index < count; index = loop->next++) {
+                (*loop_body)(index);
+            }
+            std::lock_guard<std::mutex> lock(loop->mutex);
+            if (--loop->active == 0) {
+                loop->done.notify_all();
+            }
+        });
+    }
+    for (size_t index = loop->next++; index < count; index = loop->next++) {
+        body(index);
+    }
+
+    // all indices have been claimed; wait for the helper tasks still executing them. Helper tasks that start from now on
+    // claim no index, so they are not waited for.
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    while (loop->active > 0) {
+        loop->done.wait(lock);
+    }
+}
+
+
+/**
+ * Worker thread; it executes tasks from its own deque or stolen from other deques, and sleeps while there are none.
+ * @param index the worker index
+ */
+void TaskExecutor::run(const size_t index) {
+    current_executor = this;
+    current_index = index;
+    steal_seed = (uint32_t)index * 2654435761u + 1;
+    while (stopping == false) {
+        if (runOne(index)) {
+            continue;
+        }
+        ++sleepers;
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            while (pending == 0 && stopping == false) {
+                sleep_cv.wait(lock);
+            }
+        }
+        --sleepers;
+    }
+}
+
+
+/**
+ * Execute a single task from the deque of the given worker, or stolen from another worker.
+ * @param index the worker index
+ * @return true, if a task has been executed
+ */
+bool TaskExecutor::runOne(const size_t index) {
+    Task task;
+    if (pop(index, task) || steal(index, task)) {
+        --pending;
+        task();
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Take the most recently pushed task from the back of the deque of the given worker.
+ * @param index the worker index
+ * @param task output - the task
+ * @return true, if a task has been taken
+ */
+bool TaskExecutor::pop(const size_t index, Task& task) {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task.swap(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+
+/**
+ * Steal the oldest task from the front of the deque of another worker; victims are visited starting at a random worker.
+ * @param index the worker index of the thief
+ * @param task output - the task
+ * @return true, if a task has been stolen
+ */
+bool TaskExecutor::steal(const size_t index, Task& task) {
+    const size_t n = workers.size();
+    if (n < 2 || pending == 0) {
+        return false;
+    }
+    steal_seed ^= steal_seed << 13;
+    steal_seed ^= steal_seed >> 17;
+    steal_seed ^= steal_seed << 5;
+    const size_t start = steal_seed % n;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t victim = (start + i) % n;
+        if (victim == index) {
+            continue;
+        }
+        Worker& worker = *workers[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty() == false) {
+            task.swap(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Push a task to the back of the deque of the given worker and wake up a sleeping worker.
+ * @param index the worker index
+ * @param task the task
+ */
+void TaskExecutor::push(const size_t index, const Task& task) {
+    ++pending;
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(task);
+    }
+    if (sleepers > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        sleep_cv.notify_one();
+    }
+}
+
+
+/**
+ * Check if the calling thread is a worker thread of this executor, e.g. to reject operations that must not be called from a task.
+ * @return true, if the calling thread is a worker thread of this executor
+ */
+bool TaskExecutor::isWorkerThread(void) const {
+    return current_executor == this;
+}
+
+
+/**
+ * Get the worker index of the calling thread.
+ * @param index output - the worker index
+ * @return true, if the calling thread is a worker thread of this executor
+ */
+bool TaskExecutor::getWorkerIndex(size_t& index) const {
+    if (current_executor == this) {
+        index = current_index;
+        return true;
+    }
+    return false;
+}
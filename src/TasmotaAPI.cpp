@@ -27,11 +27,11 @@
  */
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <cstring>
 #include <TasmotaAPI.hpp>
 #include <HttpClient.hpp>
 #include <Url.hpp>
 #include <JsonCpp.hpp>
-#include <locale>
 
 #ifdef LIB_NAMESPACE
 using namespace LIB_NAMESPACE;
@@ -39,14 +39,86 @@ using namespace LIB_NAMESPACE;
 using namespace libtasmota;
 #endif
 
+const char* const TasmotaAPI::status_all = "Status%200";
+
+const TasmotaAPI::StatusSection TasmotaAPI::status_sections[TasmotaAPI::num_status_sections] = {
+    { "Status",    "Status"      },
+    { "StatusPRM", "Status%201"  },
+    { "StatusFWR", "Status%202"  },
+    { "StatusLOG", "Status%203"  },
+    { "StatusMEM", "Status%204"  },
+    { "StatusNET", "Status%205"  },
+    { "StatusMQT", "Status%206"  },
+    { "StatusTIM", "Status%207"  },
+    { "StatusPTH", "Status%209"  },
+    { "StatusSNS", "Status%2010" },
+    { "StatusSTS", "Status%2011" },
+    { "StatusSHT", "Status%2013" }
+};
+
 /**
  * Constructor.
  * @param url the first part of the tasmota device url, e.g. "http://192.168.1.2"
  */
 TasmotaAPI::TasmotaAPI(const std::string& url) :
-    host_url(url)
+    endpoint(url),
+    timeout(5000),
+    previous_json(NULL),
+    max_status_age(0),
+    max_state_age(0)
+{
+    // the device url is parsed once; each request only appends the percent-encoded command to "/cm?cmnd="
+    endpoint.setPathPrefix("/cm?cmnd=");
+}
+
+/**
+ * Copy constructor; the status tree of the other instance is not shared.
+ * @param other the instance to copy
+ */
+TasmotaAPI::TasmotaAPI(const TasmotaAPI& other) :
+    endpoint(other.endpoint),
+    timeout(other.timeout),
+    previous_json(NULL),
+    max_status_age(other.max_status_age),
+    max_state_age(other.max_state_age)
 {}
 
+/**
+ * Destructor.
+ */
+TasmotaAPI::~TasmotaAPI(void) {
+    json_value_free(status_report.json);
+    for (size_t i = 0; i < num_status_sections; ++i) {
+        json_value_free(section_reports[i].json);
+    }
+    json_value_free(previous_json);
+}
+
+/**
+ * Assignment operator; the status tree of the other instance is not shared.
+ * @param other the instance to copy
+ * @return this instance
+ */
+TasmotaAPI& TasmotaAPI::operator=(const TasmotaAPI& other) {
+    if (this != &other) {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        endpoint = other.endpoint;
+        timeout = other.timeout;
+        max_status_age = other.max_status_age;
+        max_state_age = other.max_state_age;
+        json_value_free(status_report.json);
+        status_report = StatusReport();
+        for (size_t i = 0; i < num_status_sections; ++i) {
+            json_value_free(section_reports[i].json);
+            section_reports[i] = StatusReport();
+        }
+        json_value_free(previous_json);
+        previous_json = NULL;
+        clearState();
+    }
+    return *this;
+}
+
 
 /**
  * Get a vector of modules supported by the firmware.
@@ -56,15 +128,16 @@ std::map<std::string, std::string> TasmotaAPI::getModules(void) const {
     std::map<std::string, std::string> modules;
 
     // get json response from device
-    std::string http_status;
-    json_value* json = getJsonResponse("Modules", http_status);
+    std::string content;
+    int http_return_code = 0;
+    json_value* json = getJsonResponse("Modules", content, http_return_code);
     if (json != NULL) {
 
         // get Modules element and all sub-elements
-        const JsonCpp::JsonNamedValueVector roots = JsonCpp::getNamedValues(json);
-        const JsonCpp::JsonNamedValue&      root  = roots[0];
-        if (compareNames(root.getName(), "Modules", true) && root.isObject()) {
-            for (const auto element : root.asObject()) {
+        const JsonCpp::JsonObject roots(json);
+        const JsonCpp::JsonNamedValue root = (roots.size() > 0 ? roots[0] : JsonCpp::JsonNamedValue(NULL));
+        if (compareNames(root.getNameView(), JsonCpp::StringView("Modules"), true) && root.isObject()) {
+            for (const auto& element : root.asObject()) {
                 modules[element.getName()] = std::string(element.getValue());
             }
        }
@@ -80,184 +153,1029 @@ std::map<std::string, std::string> TasmotaAPI::getModules(void) const {
  * @return the value of the key value pair
  */
 std::string TasmotaAPI::getValue(const std::string& name) const {
-    std::string http_status, value;
+    std::string content, value;
+    int http_return_code = 0;
 
     // get json response from device
-    json_value* json = getJsonResponse(name, http_status);
-    if (json != NULL) {
-        // search json for the given name
-        value = getValueFromJson(json, name);
-        json_value_free(json);
+    json_value* json = getJsonResponse(name, content, http_return_code);
+    if (json == NULL) {
+        return getHttpStatus(http_return_code, content);
     }
-    if (value.length() > 0) {
-        return value;
+
+    // search json for the given name
+    value = getValueFromJson(json, name);
+    updateState(name, json);
+    if (value.length() == 0) {
+        value = getHttpStatus(http_return_code, content);
     }
-    return http_status;
+    json_value_free(json);
+    return value;
+}
+
+
+/**
+ * Get the value for the given key from the tasmota device as a double, without a string round trip.
+ * @param name the name of the key value pair, e.g. "Dimmer"
+ * @param value output - the value; integer values are converted
+ * @return VALUE_OK, or a ValueResult error code, or the http return code if it is not 200 OK
+ */
+int TasmotaAPI::getDouble(const std::string& name, double& value) const {
+    return getTypedValue(name, value);
+}
+
+/**
+ * Get the value for the given key from the tasmota device as a 64-bit integer, without a string round trip.
+ * @param name the name of the key value pair, e.g. "Module"
+ * @param value output - the value; double values are accepted if they are integral
+ * @return VALUE_OK, or a ValueResult error code, or the http return code if it is not 200 OK
+ */
+int TasmotaAPI::getInt64(const std::string& name, int64_t& value) const {
+    return getTypedValue(name, value);
+}
+
+/**
+ * Get the value for the given key from the tasmota device as a boolean.
+ * @param name the name of the key value pair, e.g. "Power"
+ * @param value output - the value; "ON" and "OFF" strings, and integers are converted
+ * @return VALUE_OK, or a ValueResult error code, or the http return code if it is not 200 OK
+ */
+int TasmotaAPI::getBool(const std::string& name, bool& value) const {
+    return getTypedValue(name, value);
+}
+
+
+/**
+ * Get the numeric value for the given compiled key path from the tasmota device, without a string round trip.
+ * The path is evaluated against the result of the narrowest "Status <n>" command containing its first segment, e.g.
+ * "Status 10" for "StatusSNS", or "Status 0" otherwise. If the path matches more than one value, the first match is used.
+ * @param path the compiled key path, e.g. CompiledPath("StatusSNS:ENERGY:Power") to get the power consumption
+ * @param value output - the value; integer values are converted
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return VALUE_OK, or a ValueResult error code, or the http return code if it is not 200 OK
+ */
+int TasmotaAPI::getNumberFromPath(const CompiledPath& path, double& value, const int max_age) const {
+    int http_return_code = 0;
+
+    // get json response from device
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* json = getStatusResponse(lock, http_return_code, max_age, getStatusCommand(path));
+    if (json == NULL) {
+        return (http_return_code != 200 ? http_return_code : (int)VALUE_INVALID_JSON);
+    }
+    JsonCpp::JsonValue leaf = path.evaluateFirst(json);
+    if (leaf.isNone()) {
+        return VALUE_NOT_FOUND;
+    }
+    return convertValue(leaf.c_ptr(), value);
+}
+
+
+/**
+ * Get the value for the given key from the tasmota device and convert it to the requested type.
+ * @param name the name of the key value pair
+ * @param value output - the value
+ * @return VALUE_OK, or a ValueResult error code, or the http return code if it is not 200 OK
+ */
+template<typename T> int TasmotaAPI::getTypedValue(const std::string& name, T& value) const {
+    std::string content;
+    int http_return_code = 0;
+
+    // get json response from device
+    json_value* json = getJsonResponse(name, content, http_return_code);
+    if (json == NULL) {
+        return (http_return_code != 200 ? http_return_code : (int)VALUE_INVALID_JSON);
+    }
+    const json_value* leaf = findValueInJson(json, name);
+    int result = (leaf != NULL ? convertValue(leaf, value) : (int)VALUE_NOT_FOUND);
+    updateState(name, json);
+    json_value_free(json);
+    return result;
 }
 
 
 /**
  * Get the value for the given key path from the tasmota device; the value is converted to a string.
  * The key path is a string containing path segments, separated by ':' characters. The path is defining
- * the traversal through the result of a "Status 0" command to the tasmota device.
- * @param key the key path of the key value pair. e.g. "StatusSNS:ENERGY:Power" to get the power consumption
+ * the traversal through the result of the narrowest "Status <n>" command containing its first segment, or "Status 0".
+ * If the value cannot be found, the http status of the report is returned, e.g. "HTTP-Returncode: 401 : ...".
+ * @param path the key path, e.g. "StatusSNS:ENERGY:Power" to get the power consumption
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
  * @return the value of the key value pair
  */
+std::string TasmotaAPI::getValueFromPath(const std::string& path, const int max_age) const {
+    std::string result;
+
+    // get json response from device
+    std::unique_lock<std::mutex> lock(status_mutex);
+    const StatusReport& report = getStatusReport(lock, getStatusCommand(path), max_age);
+    if (report.json != NULL) {
+        JsonCpp::JsonValue leaf((const json_value*)NULL);
+        if (findValueInPath(report.json, path, leaf)) {
+            result = std::string(leaf);
+        }
+    }
+    if (result.length() > 0) {
+        return result;
+    }
+    return getHttpStatus(report);
+}
+
+
 /**
- * Get the value for the given key path from the phoscon device; the value is converted to a string.
- * The key path is a string containing path segments, separated by ':' characters. The path is defining
- * the traversal through the result of a "Status 0" command to the phoscon device.
- * @param gw phoscon gateway
- * @param device zigbee device id
- * @param path the path to the leaf key value pair. e.g. "subdevices:1:state:power:value" to get the power consumption
- * @return the value of the leaf key value pair
+ * Get the value for the given compiled key path from the tasmota device; the value is converted to a string.
+ * The path is evaluated against the result of the narrowest "Status <n>" command containing its first segment, e.g.
+ * "Status 10" for "StatusSNS", or "Status 0" otherwise. If the path matches more than one value, the first match is returned.
+ * @param path the compiled key path, e.g. CompiledPath("StatusSNS:ENERGY:Power") to get the power consumption
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return the value of the first matching key value pair
  */
-std::string TasmotaAPI::getValueFromPath(const std::string& path) const {
-    std::string http_status, result;
+std::string TasmotaAPI::getValueFromPath(const CompiledPath& path, const int max_age) const {
+    std::string result;
 
     // get json response from device
-    json_value* json = getJsonResponse("Status%200", http_status);
-    if (json != NULL && json->type != json_null && json->type != json_none) {
+    std::unique_lock<std::mutex> lock(status_mutex);
+    const StatusReport& report = getStatusReport(lock, getStatusCommand(path), max_age);
+    if (report.json != NULL) {
+        JsonCpp::JsonValue value = path.evaluateFirst(report.json);
+        if (value.isNone() == false) {
+            result = std::string(value);
+        }
+    }
+    if (result.length() > 0) {
+        return result;
+    }
+    return getHttpStatus(report);
+}
 
-        // split path into segments
-        std::vector<std::string> path_segments = getPathSegments(path);
 
-        // declare name comparators for json nodes and json leafs
-        struct NameComparator {
-            static bool compare_node_names(const std::string& lhs, const std::string& rhs) { return compareNames(lhs, rhs, true); }
-            static bool compare_leaf_names(const std::string& lhs, const std::string& rhs) { return compareNames(lhs, rhs, false); }
-        };
+/**
+ * Get all values matching the given compiled key path from the tasmota device; the values are converted to strings.
+ * The path is evaluated against the result of a single "Status <n>" command containing its first segment, or "Status 0", and all
+ * matches are collected in a single traversal.
+ * @param path the compiled key path, e.g. CompiledPath("StatusSNS:ENERGY:{Power,Voltage,Current}")
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return a vector of concrete key path and value pairs, e.g. "StatusSNS:ENERGY:Power" and "42"; it is empty if nothing matched
+ */
+std::vector<std::pair<std::string, std::string> > TasmotaAPI::getValuesFromPath(const CompiledPath& path, const int max_age) const {
+    std::vector<std::pair<std::string, std::string> > values;
 
-        // traverse path
-        JsonCpp::JsonValue traveler(json);
+    // get json response from device
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* json = getStatusResponse(lock, http_return_code, max_age, getStatusCommand(path));
+    if (json != NULL) {
+        CompiledPath::MatchVector matches;
+        path.evaluate(json, matches);
+        values.reserve(matches.size());
+        for (const auto& match : matches) {
+            values.push_back(std::make_pair(match.getPath(), std::string(match.value)));
+        }
+    }
+    return values;
+}
 
-        if (path_segments.size() > 1) {
-            for (size_t i = 0; i < path_segments.size() - 1; ++i) {
-                if (traveler.isObject()) {
-                    traveler = JsonCpp::getValue(traveler.asObject(), path_segments[i], NameComparator::compare_node_names);
-                }
-                else if (traveler.isArray()) {
-                    unsigned int index = 0;
-                    if (sscanf(path_segments[i].c_str(), "%u", &index) == 1 && index < traveler.asArray().size()) {
-                        traveler = traveler.asArray()[index];
-                    }
-                    else {
-                        break;
-                    }
-                }
-                else {
-                    break;
-                }
-            }
+/**
+ * Get the values for the given key paths from the tasmota device; the values are converted to strings.
+ * All paths are resolved against the result of a single "Status <n>" command if they share the first segment, or "Status 0".
+ * @param paths the key paths, e.g. "StatusSNS:ENERGY:Power" and "StatusSNS:ENERGY:Voltage"
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return a vector holding a result code and value for each path, in the order of the given paths
+ */
+std::vector<TasmotaAPI::PathValue> TasmotaAPI::getValuesFromPaths(const std::vector<std::string>& paths, const int max_age) const {
+    std::vector<PathValue> values(paths.size());
+    if (paths.empty()) {
+        return values;
+    }
+
+    // get json response from device
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* json = getStatusResponse(lock, http_return_code, max_age, getStatusCommand(paths));
+    for (size_t i = 0; i < paths.size(); ++i) {
+        JsonCpp::JsonValue leaf((const json_value*)NULL);
+        if (json == NULL) {
+            values[i].result = (http_return_code != 200 ? http_return_code : (int)VALUE_INVALID_JSON);
         }
-        if (path_segments.size() > 0 && traveler.isObject()) {
-            JsonCpp::JsonValue leaf = JsonCpp::getValue(traveler.asObject(), path_segments[path_segments.size() - 1], NameComparator::compare_leaf_names);
-            result = std::string(leaf);
+        else if (findValueInPath(json, paths[i], leaf) && leaf.isNone() == false) {
+            values[i].result = VALUE_OK;
+            values[i].value = std::string(leaf);
+        }
+        else {
+            values[i].result = VALUE_NOT_FOUND;
         }
-        json_value_free(json);
     }
-    if (result.length() > 0) {
-        return result;
+    return values;
+}
+
+
+/**
+ * Get the values for the given compiled key paths from the tasmota device; the values are converted to strings.
+ * All paths are evaluated against the result of a single "Status <n>" command if they share the first segment, or "Status 0". If a path
+ * matches more than one value, the first match is used.
+ * @param paths the compiled key paths, e.g. CompiledPath("StatusSNS:ENERGY:Power")
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return a vector holding a result code and value for each path, in the order of the given paths
+ */
+std::vector<TasmotaAPI::PathValue> TasmotaAPI::getValuesFromPaths(const std::vector<CompiledPath>& paths, const int max_age) const {
+    std::vector<PathValue> values(paths.size());
+    if (paths.empty()) {
+        return values;
     }
-    return http_status;
+
+    // get json response from device
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* json = getStatusResponse(lock, http_return_code, max_age, getStatusCommand(paths));
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (json == NULL) {
+            values[i].result = (http_return_code != 200 ? http_return_code : (int)VALUE_INVALID_JSON);
+            continue;
+        }
+        JsonCpp::JsonValue leaf = paths[i].evaluateFirst(json);
+        if (leaf.isNone() == false) {
+            values[i].result = VALUE_OK;
+            values[i].value = std::string(leaf);
+        }
+        else {
+            values[i].result = VALUE_NOT_FOUND;
+        }
+    }
+    return values;
 }
 
 
+/**
+ * Get the values that changed in the status report of the tasmota device since the previous status report read by this instance.
+ * A "Status 0" command is sent to the tasmota device, and the response is compared against the previous response in a single
+ * simultaneous walk of both trees. For the first call, all values are reported as added. A cached status report is never used.
+ * @return a vector of changed values; it is empty, if nothing has changed or if the device cannot be reached
+ */
+std::vector<TasmotaAPI::ValueChange> TasmotaAPI::getChangedValues(void) const {
+    std::vector<ValueChange> result;
+
+    // the oldest tree is taken out and reused to parse the new response without holding the lock
+    std::string content;
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* oldest_json = previous_json;
+    previous_json = NULL;
+    lock.unlock();
+    json_value* json = getJsonResponse(status_all, content, http_return_code, oldest_json);
+
+    // the current tree becomes the previous one
+    lock.lock();
+    json_value_free(previous_json);     // the tree of a concurrent call that completed first
+    previous_json = status_report.json;
+    status_report.json = NULL;
+    setStatusReport(status_report, status_all, json, content, http_return_code);
+    updateStateFromStatus(json);
+    if (json != NULL) {
+        JsonDiff::ChangeVector changes;
+        JsonDiff::diff(previous_json, json, changes);
+        result.reserve(changes.size());
+        for (const auto& change : changes) {
+            ValueChange value_change;
+            value_change.type = change.type;
+            value_change.path_id = PathInterner::instance().find(change.path);
+            value_change.path = change.path;
+            value_change.old_value = (change.old_value.isNone() ? "" : std::string(change.old_value));
+            value_change.new_value = (change.new_value.isNone() ? "" : std::string(change.new_value));
+            result.push_back(value_change);
+        }
+    }
+    return result;
+}
+
+
+/**
+ * Get all values of the status report of the tasmota device and append them as rows to the given columnar batch.
+ * A "Status 0" command is sent to the tasmota device, and each leaf of the response is appended as a row of
+ * device id, key path id, type and value; no strings are created per value.
+ * @param batch the batch to append to; it can be reused across calls, see JsonBatch::clear()
+ * @param device_id the device id to store in each appended row
+ * @param max_age the max age in milliseconds of a cached status report, or DEFAULT_MAX_AGE
+ * @return the number of rows that have been appended; 0 if the device cannot be reached
+ */
+size_t TasmotaAPI::getStatusBatch(JsonBatch& batch, const uint32_t device_id, const int max_age) const {
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    json_value* json = getStatusResponse(lock, http_return_code, max_age);
+    return batch.flatten(json, device_id);
+}
+
 
 /**
  * Set the value in the tasmota device.
  */
 std::string TasmotaAPI::setValue(const std::string& name, const std::string& value) {
-    // assemble the tasmota device url
-    std::string device_url = assembleHttpUrl(name, value);
+    std::string result;
+    setValue(name, value, result, false);
+    return result;
+}
+
+
+/**
+ * Set the value in the tasmota device.
+ * If the state cache is enabled and the device is known to be in the requested state, no request is sent unless force is true.
+ * @param name the command name, e.g. "Power"
+ * @param value the value, e.g. "ON"
+ * @param force true to send the request in any case
+ * @return the value returned by the device, or the error information
+ */
+std::string TasmotaAPI::setValue(const std::string& name, const std::string& value, const bool force) {
+    std::string result;
+    setValue(name, value, result, force);
+    return result;
+}
+
+
+/**
+ * Set the value in the tasmota device and get a result code.
+ * If the state cache is enabled and the device is known to be in the requested state, no request is sent unless force is true.
+ * @param name the command name, e.g. "Power"
+ * @param value the value, e.g. "OFF"
+ * @param result output - the value returned by the device; the http content if the response does not contain the name,
+ *               or the http status string if the http return code is not 200 OK
+ * @param force true to send the request even if the device is known to be in the requested state
+ * @return VALUE_OK, VALUE_NOT_FOUND or VALUE_INVALID_JSON if the device answered with 200 OK, or the http return code, or -1
+ */
+int TasmotaAPI::setValue(const std::string& name, const std::string& value, std::string& result, const bool force) {
+    // skip the request if the device is known to be in the requested state
+    if (force == false && value.length() > 0 && findState(name, value, result)) {
+        return VALUE_OK;
+    }
+
+    // assemble the request target
+    std::string target = assembleTarget(name, value);
 
     // send http put request
     HttpClient http_client;
+    http_client.setTimeout(timeout);
     std::string response;
     std::string content;
-    int http_return_code = http_client.sendHttpPutRequest(device_url, "", response, content);
+    int http_return_code = http_client.sendHttpPutRequest(endpoint, target, "", response, content);
+
+    // the cached status reports no longer reflect the device state
+    invalidateStatusReports();
 
     // check if the http return code is 200 OK
     if (http_return_code == 200) {
 
         // parse json response
-        json_value* json = json_parse(content.c_str(), content.length());
+        json_settings settings = getJsonSettings();
+        json_value* json = json_parse_ex(&settings, content.c_str(), content.length(), NULL);
         if (json != NULL) {
 
             // search json for the given name
-            std::string value = getValueFromJson(json, name);
-            if (value.length() > 0) {
+            result = getValueFromJson(json, name);
+            if (result.length() > 0) {
+                updateState(name, json);
                 json_value_free(json);
-                return value;
+                return VALUE_OK;
+            }
+            json_value_free(json);
+            eraseState(name);
+            result.swap(content);
+            return VALUE_NOT_FOUND;
+        }
+        eraseState(name);
+        result.swap(content);
+        return VALUE_INVALID_JSON;
+    }
+    eraseState(name);
+    result = getHttpStatus(http_return_code, content);
+    return http_return_code;
+}
+
+
+/**
+ * Set several values in the tasmota device, using as few tasmota "Backlog" commands as possible.
+ * Each backlog command is sent as a single http request; the combined json response is then searched for each command name.
+ * The known device state of the commands is discarded; see setMaxStateAge().
+ * @param backlog the set commands
+ * @return a vector holding a result code and the returned value for each command, in the order of the commands; the result is
+ *         VALUE_NOT_FOUND if the device did not report the command in its response, e.g. because it is executed later
+ */
+std::vector<TasmotaAPI::PathValue> TasmotaAPI::setValues(const TasmotaBacklog& backlog) {
+    std::vector<PathValue> values(backlog.size());
+    std::vector<TasmotaBacklog::Range> ranges;
+    backlog.split(ranges);
+
+    HttpClient http_client;
+    http_client.setTimeout(timeout);
+    json_settings settings = getJsonSettings();
+    for (const auto& range : ranges) {
+
+        // send http put request
+        std::string target = assembleTarget(backlog.getCommand(range));
+        std::string response;
+        std::string content;
+        int http_return_code = http_client.sendHttpPutRequest(endpoint, target, "", response, content);
+
+        // the cached status reports no longer reflect the device state
+        invalidateStatusReports();
+
+        // parse json response and search it for each command name
+        json_value* json = (http_return_code == 200 ? json_parse_ex(&settings, content.c_str(), content.length(), NULL) : NULL);
+        for (size_t i = range.first; i < range.second; ++i) {
+            eraseState(backlog.getName(i));
+            if (json == NULL) {
+                values[i].result = (http_return_code != 200 ? http_return_code : (int)VALUE_INVALID_JSON);
+                continue;
+            }
+            const json_value* value = findValueInResponse(json, backlog.getName(i));
+            if (value != NULL) {
+                values[i].result = VALUE_OK;
+                values[i].value = std::string(JsonCpp::JsonValue(value));
+            }
+            else {
+                values[i].result = VALUE_NOT_FOUND;
             }
         }
         json_value_free(json);
-        return content;
     }
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "HTTP-Returncode: %d : ", http_return_code);
-    return std::string(buffer).append(content);
+    return values;
 }
 
 
 /**
- * Assemble a tasmota device url.
- * @param name the tasmota command name
+ * Assemble the request target for a tasmota command; it is appended to the "/cm?cmnd=" path prefix of the device endpoint.
+ * @param command the tasmota command name
  * @param value the value if this is a set command; provide an empty string for get commands
- * @return the device url, i.e. something like "http://192.168.1.2:80/cm?cmnd=Status%200"
+ * @return the percent-encoded request target, i.e. something like "Power%20OFF"
  */
-std::string TasmotaAPI::assembleHttpUrl(const std::string& command, const std::string& value) const {
-    // parse the given host_url to separate protocol and host
-    std::string protocol, user, password, host, path, query, fragment; int port;
-    Url::parseUrl(host_url, protocol, user, password, host, port, path, query, fragment);
+std::string TasmotaAPI::assembleTarget(const std::string& command, const std::string& value) {
+    if (value.length() == 0) {
+        return Url::percentEncode(command, '?');
+    }
+    std::string query;
+    query.reserve(command.length() + 1 + value.length());
+    query.append(command).append(" ").append(value);
+    return Url::percentEncode(query, '?');
+}
 
-    // overwrite path, query and fragment url components to reflect the given command
-    path  = "/cm";
-    query = "?cmnd=";
-    query.append(command);
-    if (value.length() > 0) {
-        query.append(" ");
-        query.append(value);
+
+/**
+ * Http content consumer feeding the content of a 200 OK reply into a json stream parser while it is arriving from the
+ * tasmota device. The raw content is kept as well, as the http status string quotes the reply verbatim.
+ */
+class JsonContentParser : public HttpClient::ContentConsumer {
+protected:
+    json_stream* stream;
+    std::string& content;
+    json_stream_status status;
+    bool parse_content;
+public:
+    JsonContentParser(std::string& _content, json_settings* settings, json_value* previous = NULL) : stream(json_stream_new(settings)), content(_content), status(json_stream_more), parse_content(false) {
+        // the content is parsed into the previous tree, which is owned by the stream from now on
+        if (stream != NULL) {
+            json_stream_reuse(stream, previous);
+        }
+        else {
+            json_value_free(previous);
+        }
     }
-    fragment.clear();
+    ~JsonContentParser(void) { json_stream_free(stream); }
 
-    // assemble the tasmota device url
-    Url url(protocol, user, password, host, path, query, fragment);
-    return url.getUrl();
-}
+    virtual bool begin(const int http_return_code) {
+        parse_content = (http_return_code == 200 && stream != NULL);
+        return true;
+    }
+
+    virtual bool consume(const char* data, size_t length) {
+        if (parse_content == true) {
+            status = json_stream_feed(stream, data, length);
+            parse_content = (status != json_stream_failed);
+        }
+        content.append(data, length);
+        return true;
+    }
+
+    json_value* finish(void) {
+        return (stream != NULL && status != json_stream_failed ? json_stream_finish(stream, NULL) : NULL);
+    }
+};
 
 
 /**
  * Get the json response for the given command om the tasmota device.
- * An http get request is send to "http://'host_url'/cm?cmnd='command'.
+ * An http get request is send to "http://'host'/cm?cmnd='command'. The json content is parsed while it is being received.
+ * @param command the tasmota command string.
+ * @param content output - the http content
+ * @param http_return_code output - the http return code
+ * @return the json response tree, or NULL if the http return code is not 200 OK or the content is not valid json
+ */
+json_value* TasmotaAPI::getJsonResponse(const std::string& command, std::string& content, int& http_return_code) const {
+    return getJsonResponse(command, content, http_return_code, NULL);
+}
+
+
+/**
+ * Get the json response for the given command om the tasmota device and parse it into a previous json response tree.
+ * The json content is parsed while it is being received; as long as it has the same structure as the previous tree,
+ * the previous tree is updated in place.
  * @param command the tasmota command string.
- * @param error
- * @return the json response tree.
+ * @param content output - the http content
+ * @param http_return_code output - the http return code
+ * @param previous the previous json response tree, or NULL; it is updated or freed in any case
+ * @return the json response tree, or NULL if the http return code is not 200 OK or the content is not valid json
  */
-json_value* TasmotaAPI::getJsonResponse(const std::string& command, std::string& http_status) const {
-    // assemble the tasmota device url
-    std::string device_url = assembleHttpUrl(command);
+json_value* TasmotaAPI::getJsonResponse(const std::string& command, std::string& content, int& http_return_code, json_value* previous) const {
+    // assemble the request target
+    std::string target = assembleTarget(command);
 
     // send http get status request
     HttpClient http_client;
+    http_client.setTimeout(timeout);
     std::string response;
-    std::string content;
-    int http_return_code = http_client.sendHttpGetRequest(device_url, response, content);
-
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "HTTP-Returncode: %d : ", http_return_code);
-    http_status = std::string(buffer).append(content);
+    json_settings settings = getJsonSettings();
+    JsonContentParser parser(content, &settings, previous);
+    http_return_code = http_client.sendHttpGetRequest(endpoint, target, response, parser);
 
     // check if the http return code is 200 OK
     if (http_return_code == 200) {
-        // parse json content
-        json_value* json = json_parse(content.c_str(), content.length());
+        // get the parsed json content
+        json_value* json = parser.finish();
         return json;
     }
     return NULL;
 }
 
 
+/**
+ * Assemble the http status string, starting with "HTTP-Returncode:", from the given status report.
+ */
+std::string TasmotaAPI::getHttpStatus(const StatusReport& report) {
+    return getHttpStatus(report.code, report.content);
+}
+
+
+/**
+ * Assemble the http status string, starting with "HTTP-Returncode:", from the http return code and content.
+ */
+std::string TasmotaAPI::getHttpStatus(const int http_return_code, const std::string& content) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "HTTP-Returncode: %d : ", http_return_code);
+    return std::string(buffer).append(content);
+}
+
+
+/**
+ * Check if the tasmota device answers the given command with well-formed json, e.g. as a health check after setValue().
+ * The response is validated without building a json tree.
+ * @param command the tasmota command string, e.g. "Status"
+ * @return true, if the http return code is 200 OK and the content is well-formed json
+ */
+bool TasmotaAPI::checkJsonResponse(const std::string& command) const {
+    // assemble the request target
+    std::string target = assembleTarget(command);
+
+    // send http get request
+    HttpClient http_client;
+    http_client.setTimeout(timeout);
+    std::string response;
+    std::string content;
+    int http_return_code = http_client.sendHttpGetRequest(endpoint, target, response, content);
+
+    // check if the http return code is 200 OK and validate the json content
+    if (http_return_code == 200) {
+        json_settings settings = getJsonSettings(json_validate_only);
+        return json_parse_ex(&settings, content.c_str(), content.length(), NULL) != NULL;
+    }
+    return false;
+}
+
+
+/**
+ * Get the json parser settings for responses from the tasmota device. The nesting depth and the number of values
+ * are limited, so that a corrupt or malicious response cannot cause unbounded allocation or deep recursion.
+ * Large objects are indexed while parsing, so that cached status reports can be read by several threads.
+ * @param flags json parser flags, e.g. json_validate_only
+ * @return the json parser settings
+ */
+json_settings TasmotaAPI::getJsonSettings(const int flags) {
+    json_settings settings = json_settings();
+    settings.settings     = flags | json_index_objects;
+    settings.max_depth    = max_json_depth;
+    settings.max_elements = max_json_elements;
+    return settings;
+}
+
+
+/**
+ * Read a new "Status 0" status report snapshot from the tasmota device, regardless of the max age of the cached one.
+ * @return true, if the device answered with a well-formed status report
+ */
+bool TasmotaAPI::refresh(void) {
+    int http_return_code = 0;
+    std::unique_lock<std::mutex> lock(status_mutex);
+    return getStatusResponse(lock, http_return_code, 0) != NULL;
+}
+
+
+/**
+ * Get the "Status 0" or a narrower "Status <n>" json response from the tasmota device; the tree of the previous call is reused.
+ * The returned tree is owned by this instance and is valid as long as the caller holds the lock.
+ * @param lock the caller's lock on status_mutex; it is released while the request is sent
+ * @param http_return_code output - the http return code
+ * @param max_age the max age in milliseconds of a cached status report, 0 to always read a new one, or DEFAULT_MAX_AGE
+ * @param command the status command, e.g. status_all or the result of getStatusCommand()
+ * @return the json response tree, or NULL
+ */
+json_value* TasmotaAPI::getStatusResponse(std::unique_lock<std::mutex>& lock, int& http_return_code, const int max_age, const char* const command) const {
+    const StatusReport& report = getStatusReport(lock, command, max_age);
+    http_return_code = report.code;
+    return report.json;
+}
+
+
+/**
+ * Get the status report for the given status command.
+ * If a "Status 0" report, which contains all sections, or a report for the same command has been received successfully
+ * within the given max age, no request is sent to the device. Otherwise the tree of the previous report for the same command
+ * is taken out of the report and the lock is released; the response is parsed into that tree while it is being received,
+ * and the new report is stored under the lock again. Each status section keeps its own report, so path reads that
+ * alternate between sections are answered from the cache as well.
+ * @param lock the caller's lock on status_mutex; it is released while the request is sent
+ * @param command the status command, e.g. status_all or the result of getStatusCommand()
+ * @param max_age the max age in milliseconds of a cached status report, 0 to always read a new one, or DEFAULT_MAX_AGE
+ * @return the status report
+ */
+const TasmotaAPI::StatusReport& TasmotaAPI::getStatusReport(std::unique_lock<std::mutex>& lock, const char* const command, const int max_age) const {
+    const long long age_limit = (max_age >= 0 ? max_age : (long long)max_status_age);
+    if (age_limit > 0) {
+        if (isFresh(status_report, status_all, age_limit)) {
+            return status_report;
+        }
+        if (isFresh(getCachedReport(command), command, age_limit)) {
+            return getCachedReport(command);
+        }
+    }
+    StatusReport& report = getCachedReport(command);
+    json_value* previous = report.json;
+    report.json = NULL;
+    lock.unlock();
+
+    std::string content;
+    int http_return_code = 0;
+    json_value* json = getJsonResponse(command, content, http_return_code, previous);
+
+    lock.lock();
+    json_value_free(report.json);   // the report of a concurrent read that completed first
+    setStatusReport(report, command, json, content, http_return_code);
+    updateStateFromStatus(json);
+    return report;
+}
+
+
+/**
+ * Get the cached status report for the given status command; each status section has its own report.
+ * @param command the status command, e.g. status_all or the result of getStatusCommand()
+ * @return the report; the caller must hold the lock on status_mutex
+ */
+TasmotaAPI::StatusReport& TasmotaAPI::getCachedReport(const char* const command) const {
+    for (size_t i = 0; i < num_status_sections; ++i) {
+        if (std::strcmp(status_sections[i].command, command) == 0) {
+            return section_reports[i];
+        }
+    }
+    return status_report;
+}
+
+
+/**
+ * Mark all cached status reports as outdated, e.g. after a command has changed the device state; the trees are kept for reuse.
+ */
+void TasmotaAPI::invalidateStatusReports(void) const {
+    std::lock_guard<std::mutex> lock(status_mutex);
+    status_report.code = 0;
+    for (size_t i = 0; i < num_status_sections; ++i) {
+        section_reports[i].code = 0;
+    }
+}
+
+
+/**
+ * Replace the given status report by a new one and timestamp it.
+ * @param report the status report to update
+ * @param command the status command
+ * @param json the new json response tree, or NULL
+ * @param content input/output - the http content; it is swapped into the report
+ * @param http_return_code the http return code
+ */
+void TasmotaAPI::setStatusReport(StatusReport& report, const char* const command, json_value* json, std::string& content, const int http_return_code) {
+    report.json = json;
+    report.command = command;
+    report.code = http_return_code;
+    report.content.swap(content);
+    report.time = std::chrono::steady_clock::now();
+}
+
+
+/**
+ * Check if the given status report has been received successfully for the given command within the given max age.
+ * @param report the status report
+ * @param command the status command
+ * @param max_age the max age in milliseconds
+ * @return true, if the status report can be used from cache
+ */
+bool TasmotaAPI::isFresh(const StatusReport& report, const char* const command, const long long max_age) {
+    if (report.json == NULL || report.code != 200 || report.command == NULL || std::strcmp(report.command, command) != 0) {
+        return false;
+    }
+    const long long age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - report.time).count();
+    return age <= max_age;
+}
+
+
+/**
+ * Get the narrowest status command for the given top-level section of the status report, e.g. "Status%2010" for "StatusSNS".
+ * @param section the section name, i.e. the first segment of a key path; it is compared case-insensitively
+ * @return the status command; status_all, if the section is not known
+ */
+const char* TasmotaAPI::getStatusCommand(const JsonCpp::StringView& section) {
+    for (size_t i = 0; i < num_status_sections; ++i) {
+        if (compareNames(section, JsonCpp::StringView(status_sections[i].section), true)) {
+            return status_sections[i].command;
+        }
+    }
+    return status_all;
+}
+
+
+/**
+ * Get the narrowest status command for the given key path, derived from its first path segment.
+ * @param path the key path, e.g. "StatusSNS:ENERGY:Power"
+ * @return the status command; status_all, if the first path segment is not a known section
+ */
+const char* TasmotaAPI::getStatusCommand(const std::string& path) {
+    JsonCpp::StringView section;
+    size_t offset = 0;
+    if (getNextPathSegment(path, offset, section)) {
+        return getStatusCommand(section);
+    }
+    return status_all;
+}
+
+
+/**
+ * Get the narrowest status command for the given compiled key path, derived from its first path segment.
+ * @param path the compiled key path, e.g. CompiledPath("StatusSNS:ENERGY:{Power,Voltage}")
+ * @return the status command; status_all, if the first path segment is not a single known section name
+ */
+const char* TasmotaAPI::getStatusCommand(const CompiledPath& path) {
+    const std::vector<CompiledPath::Segment>& segments = path.getSegments();
+    if (segments.size() > 0 && segments[0].type == CompiledPath::SEGMENT_NAME && segments[0].names.size() == 1) {
+        return getStatusCommand(JsonCpp::StringView(segments[0].names[0]));
+    }
+    return status_all;
+}
+
+
+/**
+ * Get the narrowest status command for the given key paths; a narrower command is only used if all paths are in the same section.
+ * @param paths the key paths or compiled key paths
+ * @return the status command; status_all, if the paths are in different or unknown sections
+ */
+template<typename P> const char* TasmotaAPI::getStatusCommand(const std::vector<P>& paths) {
+    const char* command = (paths.size() > 0 ? getStatusCommand(paths[0]) : status_all);
+    for (size_t i = 1; i < paths.size() && command != status_all; ++i) {
+        if (std::strcmp(getStatusCommand(paths[i]), command) != 0) {
+            command = status_all;
+        }
+    }
+    return command;
+}
+
+
+/**
+ * Find the value for the given name among all top-level entries of the given json response, e.g. of a backlog command.
+ * Names are compared case-insensitively, so that "Power2" matches "POWER2" but not "POWER1"; only if there is no such
+ * entry, relay indexes are normalized like getStateKey() does, so that "Power1" matches "POWER" and "Power" matches "POWER1".
+ * If the entry is a json object, its first value is returned, like findValueInJson() does.
+ * @param json the json response tree
+ * @param name the name of the key value pair
+ * @return the json value, or NULL if the response does not contain the name
+ */
+const json_value* TasmotaAPI::findValueInResponse(const json_value* const json, const std::string& name) {
+    const JsonCpp::JsonObject roots(json);
+    const json_object_entry* match = NULL;
+    for (size_t i = 0; i < roots.size() && match == NULL; ++i) {
+        const json_object_entry& root = roots.c_ptr()[i];
+        if (compareNames(JsonCpp::StringView(root.name, root.name_length), JsonCpp::StringView(name), true)) {
+            match = &root;
+        }
+    }
+    if (match == NULL) {
+        const std::string key = getStateKey(name);
+        for (size_t i = 0; i < roots.size() && match == NULL; ++i) {
+            const json_object_entry& root = roots.c_ptr()[i];
+            if (getStateKey(std::string(root.name, root.name_length)) == key) {
+                match = &root;
+            }
+        }
+    }
+    if (match == NULL) {
+        return NULL;
+    }
+    if (match->value->type == json_object && match->value->u.object.length > 0) {
+        return match->value->u.object.values[0].value;
+    }
+    return match->value;
+}
+
+
+/**
+ * Forget the known device state; the next setValue() calls are sent in any case.
+ */
+void TasmotaAPI::clearState(void) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    state_cache.clear();
+}
+
+
+/**
+ * Check if the device is known to be in the requested state.
+ * @param name the command name, e.g. "Power"
+ * @param value the requested value, e.g. "ON"; it is compared case-insensitively
+ * @param result output - the string setValue() returned when the state became known
+ * @return true, if the state cache is enabled and holds the same value for the name, and it is not older than the max age
+ */
+bool TasmotaAPI::findState(const std::string& name, const std::string& value, std::string& result) const {
+    if (max_state_age == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    std::map<std::string, StateEntry>::const_iterator it = state_cache.find(getStateKey(name));
+    if (it == state_cache.end() || compareNames(JsonCpp::StringView(it->second.value), JsonCpp::StringView(value), true) == false) {
+        return false;
+    }
+    const long long age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - it->second.time).count();
+    if (age > (long long)max_state_age) {
+        return false;
+    }
+    result = it->second.result;
+    return true;
+}
+
+
+/**
+ * Record the device state for the given command name, if the state cache is enabled.
+ * @param name the command name, e.g. "Power"
+ * @param value the value, e.g. "ON"
+ * @param result the string setValue() returns for it
+ */
+void TasmotaAPI::updateState(const std::string& name, const std::string& value, const std::string& result) const {
+    if (max_state_age == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    StateEntry& entry = state_cache[getStateKey(name)];
+    entry.value = value;
+    entry.result = result;
+    entry.time = std::chrono::steady_clock::now();
+}
+
+
+/**
+ * Record the device state for the given command name from the json response to a get or set command.
+ * Only values of primitive types are recorded.
+ * @param name the command name, e.g. "Power"
+ * @param json the json response, e.g. {"POWER":"ON"}
+ */
+void TasmotaAPI::updateState(const std::string& name, const json_value* const json) const {
+    if (max_state_age == 0) {
+        return;
+    }
+    const JsonCpp::JsonValue leaf(findValueInJson(json, name));
+    if (leaf.isString() || leaf.isInt() || leaf.isDouble() || leaf.isBool()) {
+        updateState(name, std::string(leaf), getValueFromJson(json, name));
+    }
+}
+
+
+/**
+ * Record the device state from the "StatusSTS" section of a status report, e.g. "POWER":"ON" or "Dimmer":50.
+ * Only values of primitive types are recorded.
+ * @param json the json status report tree, or NULL
+ */
+void TasmotaAPI::updateStateFromStatus(const json_value* const json) const {
+    if (max_state_age == 0 || json == NULL || json->type != json_object) {
+        return;
+    }
+    for (const auto& section : JsonCpp::JsonObject(json)) {
+        if (section.isObject() && compareNames(section.getNameView(), JsonCpp::StringView("StatusSTS"), true)) {
+            for (const auto& element : section.asObject()) {
+                if (element.isString() || element.isInt() || element.isDouble() || element.isBool()) {
+                    updateState(element.getName(), JsonCpp::JsonValue(element.c_ptr()), std::string(element));
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Forget the device state for the given command name, e.g. because a set command failed.
+ * @param name the command name, e.g. "Power"
+ */
+void TasmotaAPI::eraseState(const std::string& name) const {
+    if (max_state_age == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(state_mutex);
+    state_cache.erase(getStateKey(name));
+}
+
+
+/**
+ * Get the key of the state cache for the given command name, i.e. the upper-case name with a normalized relay index.
+ * Tasmota reports "Power" as "POWER" and treats "Power1" as "Power", so these names share one key; other relay
+ * indexes are kept, so that "Power2" and "Power0" (all relays) do not overwrite the state of the first relay.
+ * @param name the command name, e.g. "Power1"
+ * @return the key, e.g. "POWER"
+ */
+std::string TasmotaAPI::getStateKey(const std::string& name) {
+
+    // split the name into the command and its relay index, i.e. the trailing digits without leading zeros
+    size_t length = name.length();
+    while (length > 0 && name[length - 1] >= '0' && name[length - 1] <= '9') {
+        --length;
+    }
+    if (length == 0) {
+        length = name.length();
+    }
+    size_t index = length;
+    while (index + 1 < name.length() && name[index] == '0') {
+        ++index;
+    }
+
+    // upper-case the command and append the relay index unless it is the default relay
+    std::string key(name, 0, length);
+    for (size_t i = 0; i < key.length(); ++i) {
+        if (key[i] >= 'a' && key[i] <= 'z') {
+            key[i] = (char)(key[i] - 'a' + 'A');
+        }
+    }
+    if (name.compare(index, std::string::npos, "1") != 0) {
+        key.append(name, index, std::string::npos);
+    }
+    return key;
+}
+
+
+/**
+ * Traverse the given json tree along the given key path.
+ * Key names of intermediate segments are compared case-insensitively, the key name of the last segment additionally
+ * ignores trailing digits; on json arrays a numeric segment is used as an array index.
+ * @param json the json tree
+ * @param path the key path, e.g. "StatusSNS:ENERGY:Power"
+ * @param leaf output - the value for the last path segment; it is none, if the last key name is not found
+ * @return true, if the traversal reached a json object holding the last path segment
+ */
+bool TasmotaAPI::findValueInPath(const json_value* const json, const std::string& path, JsonCpp::JsonValue& leaf) {
+    if (json == NULL || json->type == json_null || json->type == json_none) {
+        return false;
+    }
+
+    // traverse path; segments are views into the path string, so no segment strings are allocated
+    JsonCpp::JsonValue traveler(json);
+    JsonCpp::StringView segment, next_segment;
+    size_t offset = 0;
+
+    bool has_segment = getNextPathSegment(path, offset, segment);
+    while (has_segment) {
+        bool has_next_segment = getNextPathSegment(path, offset, next_segment);
+        if (has_next_segment == false) {
+            if (traveler.isObject()) {
+                leaf = JsonCpp::findValue(traveler.asObject(), segment, json_match_nodigits);
+                return true;
+            }
+            break;
+        }
+        if (traveler.isObject()) {
+            traveler = JsonCpp::findValue(traveler.asObject(), segment, json_match_nocase);
+        }
+        else if (traveler.isArray()) {
+            unsigned int index = 0;
+            size_t num_digits = 0;
+            while (num_digits < segment.size() && segment[num_digits] >= '0' && segment[num_digits] <= '9') {
+                index = index * 10 + (segment[num_digits++] - '0');
+            }
+            if (num_digits == 0 || index >= traveler.asArray().size()) {
+                break;
+            }
+            traveler = traveler.asArray()[index];
+        }
+        else {
+            break;
+        }
+        segment = next_segment;
+    }
+    return false;
+}
+
+
 /**
  * Get the value for the given name from the given json tree.
  * @param json the json tree
@@ -268,18 +1186,18 @@ std::string TasmotaAPI::getValueFromJson(const json_value* const json, const std
     if (json != NULL) {
 
         // analyze the json response
-        const JsonCpp::JsonNamedValueVector roots = JsonCpp::getNamedValues(json);
-        const JsonCpp::JsonNamedValue&      root  = roots[0];
-        if (compareNames(root.getName(), name, false)) {
+        const JsonCpp::JsonObject roots(json);
+        if (roots.size() == 0) {
+            return "";
+        }
+        const JsonCpp::JsonNamedValue root = roots[0];
+        if (compareNames(root.getNameView(), JsonCpp::StringView(name), false)) {
             if (root.isObject()) {
-                for (const auto element : root.asObject()) {
-                    const std::string name  = element.getName();
-                    const std::string value = std::string(element.getValue());
-                    return value;
+                for (const auto& element : root.asObject()) {
+                    return std::string(element.getValue());
                 }
             }
-            const std::string value = std::string(root);
-            return value;
+            return std::string(root);
         }
     }
     return "";
@@ -287,87 +1205,135 @@ std::string TasmotaAPI::getValueFromJson(const json_value* const json, const std
 
 
 /**
- * Compare tasmota key names.
- * @param name1 the first name to compare
- * @param name2 the second name to compare
- * @param strict false: name extensions with digits are ignored; true: only differences in lower and upper case are ignored
- * @return true, if the two names are considered to be equal; false, if the two names are considered to be different
+ * Find the value for the given name in the given json response; this is the value getValueFromJson() converts to a string.
+ * @param json the json response tree
+ * @param name the name of the key value pair
+ * @return the json value, or NULL if the response does not contain the name
  */
-bool TasmotaAPI::compareNames(const std::string& name1, const std::string& name2, const bool strict) {
-
-    // first check if both strings are identical
-    if (name1 == name2) {
-        return true;
+const json_value* TasmotaAPI::findValueInJson(const json_value* const json, const std::string& name) {
+    const JsonCpp::JsonObject roots(json);
+    if (roots.size() == 0) {
+        return NULL;
     }
+    const json_object_entry& root = roots.c_ptr()[0];
+    if (compareNames(JsonCpp::StringView(root.name, root.name_length), JsonCpp::StringView(name), false) == false) {
+        return NULL;
+    }
+    if (root.value->type == json_object && root.value->u.object.length > 0) {
+        return root.value->u.object.values[0].value;
+    }
+    return root.value;
+}
 
-    // extract base names by removing any trailing digits
-    std::string base_name1 = name1;
-    std::string base_name2 = name2;
 
-    // if the comparison is not strict, consider "Module0" and "Module" as the same name
-    if (strict == false) {
-        while (base_name1.length() > 0) {
-            char last_char = base_name1.at(base_name1.length() - 1);
-            if (last_char < '0' || last_char > '9') break;
-            base_name1 = base_name1.substr(0, base_name1.length() - 1);
-        }
-        while (base_name2.length() > 0) {
-            char last_char = base_name2.at(base_name2.length() - 1);
-            if (last_char < '0' || last_char > '9') break;
-            base_name2 = base_name2.substr(0, base_name2.length() - 1);
-        }
+/**
+ * Convert a json number to a double.
+ * @return VALUE_OK or VALUE_TYPE_MISMATCH
+ */
+int TasmotaAPI::convertValue(const json_value* const json, double& value) {
+    switch (json->type) {
+    case json_integer: value = (double)json->u.integer; return VALUE_OK;
+    case json_double:  value = json->u.dbl;             return VALUE_OK;
+    default:           return VALUE_TYPE_MISMATCH;
     }
+}
 
-    // check if lengths of both strings are identical
-    if (base_name1.length() == base_name2.length()) {
+/**
+ * Convert a json number to a 64-bit integer; doubles must be integral and within range.
+ * @return VALUE_OK or VALUE_TYPE_MISMATCH
+ */
+int TasmotaAPI::convertValue(const json_value* const json, int64_t& value) {
+    switch (json->type) {
+    case json_integer:
+        value = json->u.integer;
+        return VALUE_OK;
+    case json_double:
+        if (json->u.dbl >= -9223372036854775808.0 && json->u.dbl < 9223372036854775808.0 && json->u.dbl == (double)(int64_t)json->u.dbl) {
+            value = (int64_t)json->u.dbl;
+            return VALUE_OK;
+        }
+        return VALUE_TYPE_MISMATCH;
+    default:
+        return VALUE_TYPE_MISMATCH;
+    }
+}
 
-        // check if both strings are identical, when converted to lower case
-        bool same = true;
-        for (int i = 0; i < base_name1.length(); ++i) {
-            std::string::value_type char1 = base_name1[i];
-            std::string::value_type char2 = base_name2[i];
-            if (char1 != char2) {
-                std::string::value_type char1_lower = std::tolower(char1);
-                std::string::value_type char2_lower = std::tolower(char2);
-                if (char1_lower != char2_lower) {
-                    same = false;
-                    break;
-                }
-            }
+/**
+ * Convert a json boolean, integer or "ON"/"OFF"/"true"/"false" string to a boolean.
+ * @return VALUE_OK or VALUE_TYPE_MISMATCH
+ */
+int TasmotaAPI::convertValue(const json_value* const json, bool& value) {
+    switch (json->type) {
+    case json_boolean:
+        value = (json->u.boolean != 0);
+        return VALUE_OK;
+    case json_integer:
+        value = (json->u.integer != 0);
+        return VALUE_OK;
+    case json_string: {
+        const JsonCpp::StringView text(json->u.string.ptr, json->u.string.length);
+        if (compareNames(text, JsonCpp::StringView("ON"), true) || compareNames(text, JsonCpp::StringView("true"), true)) {
+            value = true;
+            return VALUE_OK;
         }
-        if (same == true) {
-            return true;
+        if (compareNames(text, JsonCpp::StringView("OFF"), true) || compareNames(text, JsonCpp::StringView("false"), true)) {
+            value = false;
+            return VALUE_OK;
         }
+        return VALUE_TYPE_MISMATCH;
+    }
+    default:
+        return VALUE_TYPE_MISMATCH;
     }
+}
 
-    return false;
+
+/**
+ * Compare tasmota key names.
+ * @param name1 the first name to compare
+ * @param name2 the second name to compare
+ * @param strict false: name extensions with digits are ignored; true: only differences in lower and upper case are ignored
+ * @return true, if the two names are considered to be equal; false, if the two names are considered to be different
+ */
+bool TasmotaAPI::compareNames(const std::string& name1, const std::string& name2, const bool strict) {
+    return compareNames(JsonCpp::StringView(name1), JsonCpp::StringView(name2), strict);
 }
 
 
 /**
- * Segment a given key path into a vector of path segments.
- * The key path is a string containing path segments, separated by ':' characters. The path is defining
- * the traversal through the result of a "Status 0" command to the tasmota device.
- * @param key the key path of the key value pair. e.g. "StatusSNS:ENERGY:Power" to get the power consumption
- * @return a vector containing path segments, e.g. "StatusSNS", "ENERGY", "Power"
- */
-std::vector<std::string> TasmotaAPI::getPathSegments(const std::string& path) {
-    std::vector<std::string> segments;
-    std::string::size_type index = 0;
-    while (true) {
-        std::string::size_type index_next = path.find(':', index);
+ * Compare tasmota key names given as views; nothing is allocated.
+ * @param name1 the first name to compare
+ * @param name2 the second name to compare
+ * @param strict false: name extensions with digits are ignored; true: only differences in lower and upper case are ignored
+ * @return true, if the two names are considered to be equal; false, if the two names are considered to be different
+ */
+bool TasmotaAPI::compareNames(const JsonCpp::StringView& name1, const JsonCpp::StringView& name2, const bool strict) {
+    // if the comparison is not strict, consider "Module0" and "Module" as the same name; trailing digits are trimmed
+    // by moving the end index, and case is folded for ASCII letters only, without copies and independent of the locale
+    return json_names_match(name1.data(), (unsigned int)name1.size(), name2.data(), (unsigned int)name2.size(),
+                            strict ? json_match_nocase : json_match_nodigits) != 0;
+}
+
+
+/**
+ * Get the next non-empty segment of a given key path, without copying it.
+ * @param path the key path, e.g. "StatusSNS:ENERGY:Power"
+ * @param offset input/output - the offset where to start searching; it is advanced past the returned segment
+ * @param segment output - a view into the path string holding the segment, e.g. "ENERGY"
+ * @return true, if a segment was found; false, if the end of the path has been reached
+ */
+bool TasmotaAPI::getNextPathSegment(const std::string& path, size_t& offset, JsonCpp::StringView& segment) {
+    while (offset < path.length()) {
+        std::string::size_type index_next = path.find(':', offset);
         if (index_next == std::string::npos) {
-            std::string segment = path.substr(index);
-            if (segment.size() > 0) {
-                segments.push_back(segment);
-            }
-            break;
+            index_next = path.length();
         }
-        std::string segment = path.substr(index, index_next-index);
-        if (segment.size() > 0) {
-            segments.push_back(segment);
+        size_t index = offset;
+        offset = index_next + 1;
+        if (index_next > index) {
+            segment = JsonCpp::StringView(path.data() + index, index_next - index);
+            return true;
         }
-        index = index_next + 1;
     }
-    return segments;
+    return false;
 }
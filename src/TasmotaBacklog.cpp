@@ -0,0 +1,146 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <TasmotaBacklog.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+static const char   backlog_prefix[] = "Backlog ";
+static const char   backlog_separator[] = "; ";
+static const size_t backlog_prefix_length = sizeof(backlog_prefix) - 1;
+static const size_t backlog_separator_length = sizeof(backlog_separator) - 1;
+
+
+/**
+ * Constructor.
+ * @param max_length the max length of a single backlog command, including the "Backlog " prefix
+ * @param max_commands the max number of commands in a single backlog command
+ */
+TasmotaBacklog::TasmotaBacklog(const size_t _max_length, const size_t _max_commands) :
+    max_length(_max_length),
+    max_commands(_max_commands > 0 ? _max_commands : 1)
+{}
+
+
+/**
+ * Append a set command to the batch.
+ * @param name the command name, e.g. "TelePeriod"
+ * @param value the command value, e.g. "60"; it can be empty
+ * @return this instance, so that calls can be chained
+ */
+TasmotaBacklog& TasmotaBacklog::add(const std::string& name, const std::string& value) {
+    commands.push_back(std::make_pair(name, value));
+    return *this;
+}
+
+
+/**
+ * Remove all commands from the batch.
+ */
+void TasmotaBacklog::clear(void) {
+    commands.clear();
+}
+
+
+/**
+ * Split the batch into ranges of commands, such that each range fits into a single backlog command.
+ * Commands are kept in order. A command that exceeds the max length on its own gets a range of its own, and so does
+ * a command with a ';' character in its value, which is then sent without the backlog prefix.
+ * @param ranges output - the ranges of commands; previous contents are replaced
+ */
+void TasmotaBacklog::split(std::vector<Range>& ranges) const {
+    ranges.clear();
+    size_t first = 0;
+    size_t length = backlog_prefix_length;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const size_t command_length = getLength(i) + (i > first ? backlog_separator_length : 0);
+        if (i > first && (length + command_length > max_length || i - first >= max_commands || isSeparate(i) || isSeparate(i - 1))) {
+            ranges.push_back(Range(first, i));
+            first = i;
+            length = backlog_prefix_length + getLength(i);
+        }
+        else {
+            length += command_length;
+        }
+    }
+    if (first < commands.size()) {
+        ranges.push_back(Range(first, commands.size()));
+    }
+}
+
+
+/**
+ * Assemble the backlog command for the given range of commands.
+ * @param range the range of commands, as returned by split()
+ * @return the backlog command, e.g. "Backlog Power ON; TelePeriod 60"; a single command with a ';' character in its
+ *         value is returned as a plain command, e.g. "Rule1 ON Power1#State DO Backlog Power2 ON; Power3 ON ENDON"
+ */
+std::string TasmotaBacklog::getCommand(const Range& range) const {
+    std::string command;
+    command.reserve(backlog_prefix_length + 32 * (range.second - range.first));
+    if (range.second - range.first != 1 || isSeparate(range.first) == false) {
+        command.append(backlog_prefix, backlog_prefix_length);
+    }
+    for (size_t i = range.first; i < range.second; ++i) {
+        if (i > range.first) {
+            command.append(backlog_separator, backlog_separator_length);
+        }
+        command.append(commands[i].first);
+        if (commands[i].second.length() > 0) {
+            command.append(" ").append(commands[i].second);
+        }
+    }
+    return command;
+}
+
+
+/**
+ * Get the length of the given command in a backlog command, i.e. "name value".
+ * @param index the index of the command
+ * @return the length in characters
+ */
+size_t TasmotaBacklog::getLength(const size_t index) const {
+    const std::pair<std::string, std::string>& command = commands[index];
+    return command.first.length() + (command.second.length() > 0 ? 1 + command.second.length() : 0);
+}
+
+
+/**
+ * Check if the given command must be sent on its own, i.e. its value contains a ';' character that the device
+ * would otherwise take as the separator of backlog commands.
+ * @param index the index of the command
+ * @return true, if the command must be sent without the backlog prefix and without other commands
+ */
+bool TasmotaBacklog::isSeparate(const size_t index) const {
+    return commands[index].second.find(';') != std::string::npos;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <TasmotaFleet.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Constructor of a registered device; the key paths are compiled once.
+ */
+TasmotaFleet::Device::Device(const DeviceId _id, const std::string& url, const unsigned int interval_ms, const std::vector<std::string>& _paths) :
+    id(_id),
+    api(url),
+    interval(std::chrono::milliseconds(interval_ms > 0 ? interval_ms : 1)),
+    busy(false)
+{
+    paths.reserve(_paths.size());
+    for (const auto& path : _paths) {
+        paths.push_back(CompiledPath(path));
+    }
+}
+
+
+/**
+ * Constructor. The fleet is created stopped; call start() to begin polling.
+ * @param callback the callback receiving the poll results; it is invoked concurrently from the worker threads
+ * @param num_workers the number of worker threads, i.e. the max number of concurrent polls; 0 to use the number of cpu cores
+ * @param max_jitter the max random delay of each poll, as a fraction of the poll interval, e.g. 0.1
+ */
+TasmotaFleet::TasmotaFleet(const Callback& _callback, const size_t _num_workers, const double _max_jitter) :
+    callback(_callback),
+    num_workers(_num_workers > 0 ? _num_workers : std::thread::hardware_concurrency()),
+    max_jitter(_max_jitter > 0.0 ? _max_jitter : 0.0),
+    random((unsigned int)Clock::now().time_since_epoch().count()),
+    next_device_id(0),
+    running(false)
+{
+    if (num_workers == 0) {
+        num_workers = 1;
+    }
+}
+
+
+/**
+ * Destructor; polling is stopped. The fleet must not be destroyed from the callback, see stop().
+ */
+TasmotaFleet::~TasmotaFleet(void) {
+    stop();
+}
+
+
+/**
+ * Register a device. Its first poll is placed at a random offset within the poll interval.
+ * @param url the tasmota device url, e.g. "http://192.168.1.2"
+ * @param interval_ms the poll interval in milliseconds
+ * @param paths the key paths to read in each poll, e.g. "StatusSNS:ENERGY:Power"
+ * @return the device id; it is passed to the callback with each poll result
+ */
+TasmotaFleet::DeviceId TasmotaFleet::addDevice(const std::string& url, const unsigned int interval_ms, const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const DeviceId device_id = next_device_id++;
+    DevicePtr device(new Device(device_id, url, interval_ms, paths));
+    std::uniform_int_distribution<Clock::rep> offset(0, device->interval.count() - 1);
+    device->base = Clock::now() + Clock::duration(offset(random));
+    devices[device_id] = device;
+    Schedule entry = { device->base, device_id };
+    schedule.push(entry);
+    schedule_cv.notify_one();
+    return device_id;
+}
+
+
+/**
+ * Unregister a device. A poll that is already running is completed and delivered.
+ * @param device_id the device id, as returned by addDevice()
+ * @return true, if the device has been registered
+ */
+bool TasmotaFleet::removeDevice(const DeviceId device_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return devices.erase(device_id) > 0;
+}
+
+
+/**
+ * Get the number of registered devices.
+ * @return the number of devices
+ */
+size_t TasmotaFleet::size(void) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return devices.size();
+}
+
+
+/**
+ * Get the poll statistics of a device.
+ * @param device_id the device id, as returned by addDevice()
+ * @param statistics output - the poll statistics
+ * @return true, if the device is registered
+ */
+bool TasmotaFleet::getStatistics(const DeviceId device_id, DeviceStatistics& statistics) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<DeviceId, DevicePtr>::const_iterator it = devices.find(device_id);
+    if (it == devices.end()) {
+        return false;
+    }
+    statistics = it->second->statistics;
+    return true;
+}
+
+
+/**
+ * Start the scheduler and the worker threads. Polls of all devices are spread anew over their poll intervals.
+ */
+void TasmotaFleet::start(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+
+    // rebuild the schedule, so that polls that fell due while stopped are not counted as missed
+    schedule = std::priority_queue<Schedule, std::vector<Schedule>, std::greater<Schedule> >();
+    const Clock::time_point now = Clock::now();
+    for (const auto& entry : devices) {
+        Device& device = *entry.second;
+        std::uniform_int_distribution<Clock::rep> offset(0, device.interval.count() - 1);
+        device.base = now + Clock::duration(offset(random));
+        device.busy = false;
+        Schedule next = { device.base, device.id };
+        schedule.push(next);
+    }
+
+    executor.reset(new TaskExecutor(num_workers));
+    scheduler = std::thread(&TasmotaFleet::runScheduler, this);
+}
+
+
+/**
+ * Stop the scheduler and the worker threads. Running polls are completed and delivered; queued polls are dropped.
+ * The fleet cannot be stopped from the callback, as the worker thread delivering the result would have to join itself.
+ * @return true, if the fleet has been stopped or was not running; false, if called from the callback
+ */
+bool TasmotaFleet::stop(void) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running == false) {
+            return true;
+        }
+        if (executor->isWorkerThread()) {
+            return false;
+        }
+        running = false;
+        schedule_cv.notify_all();
+    }
+    scheduler.join();
+    executor.reset();
+    return true;
+}
+
+
+/**
+ * Get the due time of the next poll of a device; the caller must hold the mutex.
+ * @param device the device; its poll interval base has already been advanced
+ * @return the poll interval base, delayed by a random jitter
+ */
+TasmotaFleet::Clock::time_point TasmotaFleet::getDueTime(const Device& device) {
+    const Clock::rep max_delay = (Clock::rep)(max_jitter * device.interval.count());
+    if (max_delay <= 0) {
+        return device.base;
+    }
+    std::uniform_int_distribution<Clock::rep> delay(0, max_delay);
+    return device.base + Clock::duration(delay(random));
+}
+
+
+/**
+ * Scheduler thread; it submits due polls from the schedule to the executor.
+ */
+void TasmotaFleet::runScheduler(void) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (schedule.empty()) {
+            schedule_cv.wait(lock);
+            continue;
+        }
+        const Schedule entry = schedule.top();
+        const Clock::time_point now = Clock::now();
+        if (entry.due > now) {
+            schedule_cv.wait_until(lock, entry.due);
+            continue;
+        }
+        schedule.pop();
+
+        // skip devices that have been removed
+        std::map<DeviceId, DevicePtr>::iterator it = devices.find(entry.device_id);
+        if (it == devices.end()) {
+            continue;
+        }
+        Device& device = *it->second;
+
+        // queue the poll, unless the previous poll is still running
+        if (device.busy) {
+            ++device.statistics.skipped;
+            ++device.statistics.missed_deadlines;
+        }
+        else {
+            device.busy = true;
+            Task task = { it->second, entry.due };
+            executor->submit(std::bind(&TasmotaFleet::poll, this, task));
+        }
+
+        // schedule the next poll; intervals that have already passed are skipped
+        device.base += device.interval;
+        while (device.base + device.interval <= now) {
+            device.base += device.interval;
+            ++device.statistics.skipped;
+            ++device.statistics.missed_deadlines;
+        }
+        Schedule next = { getDueTime(device), device.id };
+        schedule.push(next);
+    }
+}
+
+
+/**
+ * Execute a poll, update the statistics of the device and deliver the result to the callback.
+ * @param task the poll
+ */
+void TasmotaFleet::poll(const Task& task) {
+    Device& device = *task.device;
+    PollResult result;
+    result.device_id = device.id;
+
+    // read all paths with a single request; the device is not polled by any other thread while it is busy
+    const Clock::time_point started = Clock::now();
+    result.values = device.api.getValuesFromPaths(device.paths, 0);
+    const Clock::time_point finished = Clock::now();
+
+    result.lag = std::chrono::duration_cast<std::chrono::milliseconds>(started - task.due).count();
+    result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(finished - started).count();
+    result.missed_deadline = (finished > task.due + device.interval);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        DeviceStatistics& statistics = device.statistics;
+        ++statistics.polls;
+        statistics.missed_deadlines += (result.missed_deadline ? 1 : 0);
+        statistics.last_lag = result.lag;
+        statistics.max_lag = (result.lag > statistics.max_lag ? result.lag : statistics.max_lag);
+        statistics.total_lag += result.lag;
+        device.busy = false;
+    }
+    if (callback) {
+        callback(result);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <TasmotaGroup.hpp>
+#include <chrono>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Constructor.
+ * @param executor the executor running the device requests; it can be shared with other groups and tasks. If all of its
+ *        workers are busy, the calling thread sends the requests itself, so that the deadline still holds
+ * @param max_concurrency the max number of concurrent device requests; 0 to use the number of worker threads of the executor
+ */
+TasmotaGroup::TasmotaGroup(TaskExecutor& _executor, const size_t _max_concurrency) :
+    executor(_executor),
+    max_concurrency(_max_concurrency)
+{}
+
+
+/**
+ * Add a device to the group.
+ * @param url the tasmota device url, e.g. "http://192.168.1.2"
+ * @return the index of the device in the outcome vectors of group commands
+ */
+size_t TasmotaGroup::addDevice(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex);
+    devices.push_back(std::unique_ptr<TasmotaAPI>(new TasmotaAPI(url)));
+    return devices.size() - 1;
+}
+
+
+/**
+ * Get the number of devices in the group.
+ * @return the number of devices
+ */
+size_t TasmotaGroup::size(void) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return devices.size();
+}
+
+
+/**
+ * Set the value in all devices of the group concurrently, e.g. setValue("Power", "OFF", 2000).
+ * @param name the command name, e.g. "Power"
+ * @param value the value, e.g. "OFF"
+ * @param deadline_ms the overall deadline in milliseconds, counted from the start of the group command
+ * @return the outcome for each device, in the order the devices have been added; devices that did not answer within
+ *         the deadline have the result VALUE_TIMEOUT
+ */
+std::vector<TasmotaGroup::Outcome> TasmotaGroup::setValue(const std::string& name, const std::string& value, const unsigned int deadline_ms) {
+    typedef std::chrono::steady_clock Clock;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Outcome> outcomes(devices.size());
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + std::chrono::milliseconds(deadline_ms);
+
+    executor.parallelFor(devices.size(), [&](const size_t index) {
+        Outcome& outcome = outcomes[index];
+        // round up, so that the http timeout does not end before the deadline
+        long long remaining = (std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count() + 999) / 1000;
+        if (remaining <= 0) {
+            outcome.duration = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+            return;
+        }
+
+        // limit the http timeout to the time remaining until the deadline
+        TasmotaAPI& device = *devices[index];
+        device.setTimeout((int)remaining);
+        outcome.result = device.setValue(name, value, outcome.value);
+        const Clock::time_point finished = Clock::now();
+        outcome.duration = std::chrono::duration_cast<std::chrono::milliseconds>(finished - start).count();
+        if (outcome.result == TasmotaAPI::VALUE_NETWORK_ERROR && finished >= deadline) {
+            outcome.result = TasmotaAPI::VALUE_TIMEOUT;
+        }
+    }, max_concurrency);
+
+    return outcomes;
+}
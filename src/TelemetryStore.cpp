@@ -0,0 +1,359 @@
+/*
+ * Copyright(C) 2022 RalfO. All rights reserved.
+ * https://github.com/RalfOGit/libtasmota
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <TelemetryStore.hpp>
+
+#ifdef LIB_NAMESPACE
+using namespace LIB_NAMESPACE;
+#else
+using namespace libtasmota;
+#endif
+
+
+/**
+ * Accumulate minimum, maximum and sum of a contiguous block of values.
+ */
+static void accumulateValues(const double* const values, const size_t count, double& min, double& max, double& sum) {
+    double lmin = min, lmax = max, lsum = sum;
+    for (size_t i = 0; i < count; ++i) {
+        const double value = values[i];
+        lmin = (value < lmin ? value : lmin);
+        lmax = (value > lmax ? value : lmax);
+        lsum += value;
+    }
+    min = lmin; max = lmax; sum = lsum;
+}
+
+
+/**
+ * Integrate a contiguous block of samples using the trapezoidal rule.
+ * @return the sum of (t[i] - t[i-1]) * (v[i] + v[i-1]), i.e. twice the integral in value * time units
+ */
+static double integrateValues(const int64_t* const times, const double* const values, const size_t count) {
+    double sum = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+        sum += (double)(times[i] - times[i - 1]) * (values[i] + values[i - 1]);
+    }
+    return sum;
+}
+
+
+/**
+ * Constructor. No sample memory is allocated until series are added.
+ * @param samples_per_series the number of samples kept per series, e.g. 360 for one hour of 10 second polls; at least 1
+ * @param max_num_series the maximum number of series, e.g. 5000 devices times 4 key paths
+ */
+TelemetryStore::TelemetryStore(const size_t samples_per_series, const size_t max_num_series) :
+    capacity(samples_per_series > 0 ? samples_per_series : 1),
+    max_series(max_num_series)
+{}
+
+
+/**
+ * Add a series for the given device and key path. The sample arrays grow geometrically as series are added, but never
+ * beyond max_series blocks; growing moves the samples of the existing series.
+ * @param device_id the device id, e.g. as used in JsonBatch or TasmotaFleet
+ * @param path_id the interned key path, e.g. PathInterner::instance().intern("StatusSNS:ENERGY:Power")
+ * @return the series id; the existing one if the series has been added before, or INVALID_SERIES if the maximum number of series is reached
+ */
+TelemetryStore::SeriesId TelemetryStore::addSeries(const uint32_t device_id, const PathInterner::PathId path_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return addSeriesLocked(device_id, path_id);
+}
+
+
+/**
+ * Find the series for the given device and key path.
+ * @param device_id the device id
+ * @param path_id the interned key path
+ * @return the series id, or INVALID_SERIES
+ */
+TelemetryStore::SeriesId TelemetryStore::findSeries(const uint32_t device_id, const PathInterner::PathId path_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint64_t, SeriesId>::const_iterator it = series_ids.find(getKey(device_id, path_id));
+    return (it != series_ids.end() ? it->second : INVALID_SERIES);
+}
+
+
+/**
+ * Append a sample to the given series; if the series is full, the oldest sample is overwritten.
+ * @param series_id the series id
+ * @param time the sample time in milliseconds, e.g. since the epoch; times must not decrease within a series
+ * @param value the sample value
+ * @return true, if the sample has been appended; false, if the series does not exist or the time is older than the latest sample
+ */
+bool TelemetryStore::append(const SeriesId series_id, const int64_t time, const double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendLocked(series_id, time, value);
+}
+
+
+/**
+ * Append a sample to the series of the given device and key path; the series is added if necessary.
+ * @param device_id the device id
+ * @param path_id the interned key path
+ * @param time the sample time in milliseconds; times must not decrease within a series
+ * @param value the sample value
+ * @return true, if the sample has been appended; false, if the series cannot be added or the time is older than the latest sample
+ */
+bool TelemetryStore::append(const uint32_t device_id, const PathInterner::PathId path_id, const int64_t time, const double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendLocked(addSeriesLocked(device_id, path_id), time, value);
+}
+
+
+/**
+ * Append the integer and double rows of the given batch, e.g. a flattened status report, to their series.
+ * Only rows of series that have been added before are appended, so that a full status report does not add a series for each of its values;
+ * as series are added for interned key paths, rows with batch-local path ids are skipped.
+ * @param batch the batch
+ * @param time the sample time in milliseconds for all rows
+ * @return the number of appended samples
+ */
+size_t TelemetryStore::append(const JsonBatch& batch, const int64_t time) {
+    const std::vector<uint32_t>& device_ids = batch.getDeviceIds();
+    const std::vector<PathInterner::PathId>& path_ids = batch.getPathIds();
+    const std::vector<uint8_t>& types = batch.getTypes();
+    size_t num_appended = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t row = 0; row < batch.size(); ++row) {
+        if (types[row] != JsonBatch::VALUE_INTEGER && types[row] != JsonBatch::VALUE_DOUBLE) {
+            continue;
+        }
+        std::unordered_map<uint64_t, SeriesId>::const_iterator it = series_ids.find(getKey(device_ids[row], path_ids[row]));
+        if (it != series_ids.end()) {
+            const double value = (types[row] == JsonBatch::VALUE_INTEGER ? (double)batch.getIntegers()[row] : batch.getDoubles()[row]);
+            num_appended += (appendLocked(it->second, time, value) ? 1 : 0);
+        }
+    }
+    return num_appended;
+}
+
+
+/**
+ * Copy the samples of the given series within a time window, oldest first.
+ * @param series_id the series id
+ * @param from_time the start of the window in milliseconds, inclusive
+ * @param to_time the end of the window in milliseconds, inclusive
+ * @param times output - the sample times are appended
+ * @param values output - the sample values are appended
+ * @return the number of samples appended
+ */
+size_t TelemetryStore::getSamples(const SeriesId series_id, const int64_t from_time, const int64_t to_time, std::vector<int64_t>& times_out, std::vector<double>& values_out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (series_id >= series.size()) {
+        return 0;
+    }
+    const Series& s = series[series_id];
+    const size_t first = lowerBound(series_id, from_time);
+    const size_t last = upperBound(series_id, to_time);
+    const size_t base = series_id * capacity;
+    for (size_t position = first; position < last; ++position) {
+        const size_t index = base + getIndex(s, position);
+        times_out.push_back(times[index]);
+        values_out.push_back(values[index]);
+    }
+    return (last > first ? last - first : 0);
+}
+
+
+/**
+ * Compute minimum, maximum, mean and integral of the samples of the given series within a time window.
+ * @param series_id the series id
+ * @param from_time the start of the window in milliseconds, inclusive
+ * @param to_time the end of the window in milliseconds, inclusive
+ * @param result output - the aggregates; count is 0 and all other members are 0 if the window is empty
+ * @return true, if the window holds at least one sample
+ */
+bool TelemetryStore::aggregate(const SeriesId series_id, const int64_t from_time, const int64_t to_time, Aggregate& result) const {
+    result = Aggregate();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (series_id >= series.size()) {
+        return false;
+    }
+    const Series& s = series[series_id];
+    const size_t first = lowerBound(series_id, from_time);
+    const size_t last = upperBound(series_id, to_time);
+    if (last <= first) {
+        return false;
+    }
+
+    // the window consists of at most two contiguous blocks, before and after the wrap-around of the ring buffer
+    const size_t base = series_id * capacity;
+    const size_t index1 = getIndex(s, first);
+    const size_t count = last - first;
+    const size_t count1 = (count < capacity - index1 ? count : capacity - index1);
+    const size_t count2 = count - count1;
+    const int64_t* const times1 = &times[base + index1];
+    const double*  const values1 = &values[base + index1];
+    const int64_t* const times2 = &times[base];
+    const double*  const values2 = &values[base];
+
+    double min = values1[0], max = values1[0], sum = 0.0;
+    accumulateValues(values1, count1, min, max, sum);
+    accumulateValues(values2, count2, min, max, sum);
+    double integral = integrateValues(times1, values1, count1) + integrateValues(times2, values2, count2);
+    if (count2 > 0) {
+        integral += (double)(times2[0] - times1[count1 - 1]) * (values2[0] + values1[count1 - 1]);
+    }
+
+    result.count = count;
+    result.first_time = times1[0];
+    result.last_time = (count2 > 0 ? times2[count2 - 1] : times1[count1 - 1]);
+    result.min = min;
+    result.max = max;
+    result.mean = sum / (double)count;
+    result.integral = integral * 0.0005;    // halved for the trapezoidal rule, and milliseconds to seconds
+    return true;
+}
+
+
+/**
+ * Get the number of samples in the given series.
+ * @param series_id the series id
+ * @return the number of samples, at most the capacity
+ */
+size_t TelemetryStore::size(const SeriesId series_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (series_id < series.size() ? series[series_id].count : 0);
+}
+
+
+/**
+ * Remove all samples from all series. The series and their memory are kept.
+ */
+void TelemetryStore::clear(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < series.size(); ++i) {
+        series[i].start = 0;
+        series[i].count = 0;
+    }
+}
+
+
+/**
+ * Get the number of series.
+ * @return the number of series added so far
+ */
+size_t TelemetryStore::getNumSeries(void) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return series.size();
+}
+
+
+/**
+ * Add a series; the mutex must be held by the caller.
+ */
+TelemetryStore::SeriesId TelemetryStore::addSeriesLocked(const uint32_t device_id, const PathInterner::PathId path_id) {
+    const uint64_t key = getKey(device_id, path_id);
+    std::unordered_map<uint64_t, SeriesId>::const_iterator it = series_ids.find(key);
+    if (it != series_ids.end()) {
+        return it->second;
+    }
+    if (series.size() >= max_series || series.size() >= (size_t)INVALID_SERIES) {
+        return INVALID_SERIES;
+    }
+
+    // grow the sample arrays geometrically, but never beyond the memory bound of max_series blocks
+    const size_t required = (series.size() + 1) * capacity;
+    if (required > times.capacity()) {
+        size_t reserved = 2 * times.capacity();
+        reserved = (reserved < required ? required : reserved);
+        reserved = (reserved > max_series * capacity ? max_series * capacity : reserved);
+        times.reserve(reserved);
+        values.reserve(reserved);
+    }
+    times.resize(required, 0);
+    values.resize(required, 0.0);
+
+    Series s;
+    s.device_id = device_id;
+    s.path_id = path_id;
+    s.start = 0;
+    s.count = 0;
+    const SeriesId series_id = (SeriesId)series.size();
+    series.push_back(s);
+    series_ids[key] = series_id;
+    return series_id;
+}
+
+
+/**
+ * Append a sample; the mutex must be held by the caller.
+ */
+bool TelemetryStore::appendLocked(const SeriesId series_id, const int64_t time, const double value) {
+    if (series_id >= series.size()) {
+        return false;
+    }
+    Series& s = series[series_id];
+    const size_t base = series_id * capacity;
+    if (s.count > 0 && time < times[base + getIndex(s, s.count - 1)]) {
+        return false;
+    }
+    const size_t index = base + getIndex(s, s.count);
+    times[index] = time;
+    values[index] = value;
+    if (s.count < capacity) {
+        ++s.count;
+    }
+    else {
+        s.start = (uint32_t)((s.start + 1) % capacity);
+    }
+    return true;
+}
+
+
+/**
+ * Binary search for the position of the first sample with a time not before the given time; the mutex must be held by the caller.
+ */
+size_t TelemetryStore::lowerBound(const SeriesId series_id, const int64_t time) const {
+    const Series& s = series[series_id];
+    const int64_t* const block = &times[series_id * capacity];
+    size_t low = 0, high = s.count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (block[getIndex(s, mid)] < time) low = mid + 1; else high = mid;
+    }
+    return low;
+}
+
+
+/**
+ * Binary search for the position of the first sample with a time after the given time; the mutex must be held by the caller.
+ */
+size_t TelemetryStore::upperBound(const SeriesId series_id, const int64_t time) const {
+    const Series& s = series[series_id];
+    const int64_t* const block = &times[series_id * capacity];
+    size_t low = 0, high = s.count;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (block[getIndex(s, mid)] <= time) low = mid + 1; else high = mid;
+    }
+    return low;
+}